@@ -0,0 +1,432 @@
+// Runs vector lifecycles with every allocator the library ships, and with
+// std::allocator and a counting allocator for reference, on 1, 2, 4, ...
+// threads, and prints the results as JSON:
+//
+//     allocator-bench [--threads N] [--iterations K] > results.json
+//
+// Each configuration runs in its own process, so the reported peak RSS
+// belongs to that configuration alone. Allocator calls are counted by a
+// wrapper around every allocator.
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "arena.h"
+#include "caching_allocator.h"
+#include "malloc_allocator.h"
+#include "mmap_allocator.h"
+#include "vector.h"
+
+namespace {
+struct call_counts {
+    std::size_t allocate = 0;
+    std::size_t deallocate = 0;
+    std::size_t reallocate = 0;
+};
+
+thread_local call_counts thread_calls;
+
+// Forwards to `Alloc`, counting calls in thread-local counters.
+template <typename Alloc>
+class counted : public Alloc {
+    using traits = std::allocator_traits<Alloc>;
+
+public:
+    using value_type = typename traits::value_type;
+
+    template <typename U>
+    struct rebind {
+        using other = counted<typename traits::template rebind_alloc<U>>;
+    };
+
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    counted(const Alloc &allocator) noexcept : Alloc(allocator) {
+    }
+
+    template <typename Other>
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    counted(const counted<Other> &other) noexcept
+        : Alloc(static_cast<const Other &>(other)) {
+    }
+
+    value_type *allocate(std::size_t count) {
+        thread_calls.allocate++;
+        return Alloc::allocate(count);
+    }
+
+    void deallocate(value_type *pointer, std::size_t count) noexcept {
+        thread_calls.deallocate++;
+        Alloc::deallocate(pointer, count);
+    }
+
+    template <typename Base = Alloc,
+              typename = decltype(std::declval<Base &>().reallocate(
+                  nullptr, std::size_t{}, std::size_t{}))>
+    value_type *reallocate(value_type *pointer,
+                           std::size_t old_count,
+                           std::size_t new_count) {
+        thread_calls.reallocate++;
+        return Base::reallocate(pointer, old_count, new_count);
+    }
+
+    counted select_on_container_copy_construction() const {
+        return counted(traits::select_on_container_copy_construction(*this));
+    }
+
+    friend bool operator==(const counted &lhs, const counted &rhs) noexcept {
+        return static_cast<const Alloc &>(lhs) ==
+               static_cast<const Alloc &>(rhs);
+    }
+
+    friend bool operator!=(const counted &lhs, const counted &rhs) noexcept {
+        return !(lhs == rhs);
+    }
+};
+
+std::atomic<std::size_t> counting_allocations{0};
+std::atomic<std::size_t> counting_deallocations{0};
+
+// Like the tests' CounterAllocator: operator new plus shared counters.
+template <typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_allocator() noexcept = default;
+
+    template <typename U>
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    counting_allocator(const counting_allocator<U> &) noexcept {
+    }
+
+    T *allocate(std::size_t count) {
+        counting_allocations.fetch_add(1, std::memory_order_relaxed);
+        return static_cast<T *>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T *pointer, std::size_t) noexcept {
+        counting_deallocations.fetch_add(1, std::memory_order_relaxed);
+        ::operator delete(pointer);
+    }
+
+    friend bool operator==(const counting_allocator &,
+                           const counting_allocator &) noexcept {
+        return true;
+    }
+
+    friend bool operator!=(const counting_allocator &,
+                           const counting_allocator &) noexcept {
+        return false;
+    }
+};
+
+// A strategy is created once per thread; allocator() hands out the
+// allocator for the next vectors and recycle() is called when all of them
+// were destroyed.
+template <template <typename> class Allocator>
+struct stateless_strategy {
+    [[nodiscard]] counted<Allocator<int>> allocator() const {
+        return Allocator<int>();
+    }
+
+    void recycle() {
+    }
+};
+
+struct arena_strategy {
+    lab_07::arena source;
+
+    [[nodiscard]] counted<lab_07::arena_allocator<int>> allocator() {
+        return lab_07::arena_allocator<int>(source);
+    }
+
+    void recycle() {
+        source.reset();
+    }
+};
+
+struct pool_strategy {
+    std::pmr::unsynchronized_pool_resource pool;
+
+    [[nodiscard]] counted<std::pmr::polymorphic_allocator<int>> allocator() {
+        return std::pmr::polymorphic_allocator<int>(&pool);
+    }
+
+    void recycle() {
+    }
+};
+
+template <typename T>
+using mmap_allocator = lab_07::mmap_allocator<T>;
+
+template <typename Alloc, typename U>
+using rebound = typename std::allocator_traits<Alloc>::template rebind_alloc<U>;
+
+volatile std::size_t sink;
+
+// Each lifecycle runs `iterations` operations and returns how many.
+struct build_and_discard {
+    static constexpr const char *name = "build_and_discard";
+
+    template <typename Strategy>
+    static std::size_t run(Strategy &strategy, std::size_t iterations) {
+        for (std::size_t iteration = 0; iteration < iterations; iteration++) {
+            lab_07::vector<int, decltype(strategy.allocator())> vec(
+                strategy.allocator());
+            for (int value = 0; value < 1'000; value++) {
+                vec.push_back(int{value});
+            }
+            sink = vec.size();
+            strategy.recycle();
+        }
+        return iterations;
+    }
+};
+
+struct long_lived_growth {
+    static constexpr const char *name = "long_lived_growth";
+
+    template <typename Strategy>
+    static std::size_t run(Strategy &strategy, std::size_t iterations) {
+        std::size_t pushes = iterations * 1'000;
+        {
+            lab_07::vector<int, decltype(strategy.allocator())> vec(
+                strategy.allocator());
+            for (std::size_t value = 0; value < pushes; value++) {
+                vec.push_back(static_cast<int>(value));
+            }
+            sink = vec.size();
+        }
+        strategy.recycle();
+        return pushes;
+    }
+};
+
+struct many_small_vectors {
+    static constexpr const char *name = "many_small_vectors";
+
+    template <typename Strategy>
+    static std::size_t run(Strategy &strategy, std::size_t iterations) {
+        using small = lab_07::vector<int, decltype(strategy.allocator())>;
+        for (std::size_t iteration = 0; iteration < iterations; iteration++) {
+            std::vector<small> vectors;
+            vectors.reserve(100);
+            for (int index = 0; index < 100; index++) {
+                vectors.emplace_back(strategy.allocator());
+                for (int value = 0; value < 8; value++) {
+                    vectors.back().push_back(int{value});
+                }
+            }
+            sink = vectors.size();
+            vectors.clear();
+            strategy.recycle();
+        }
+        return iterations;
+    }
+};
+
+struct vector_of_vectors {
+    static constexpr const char *name = "vector_of_vectors";
+
+    template <typename Strategy>
+    static std::size_t run(Strategy &strategy, std::size_t iterations) {
+        using allocator = decltype(strategy.allocator());
+        using inner = lab_07::vector<int, allocator>;
+        // lab_07::vector needs nothrow move assignment of its elements,
+        // which vectors with stateful allocators do not have.
+        using outer = std::vector<inner, rebound<allocator, inner>>;
+        for (std::size_t iteration = 0; iteration < iterations; iteration++) {
+            {
+                outer vectors{rebound<allocator, inner>(strategy.allocator())};
+                for (int index = 0; index < 100; index++) {
+                    inner row(strategy.allocator());
+                    for (int value = 0; value < 100; value++) {
+                        row.push_back(int{value});
+                    }
+                    vectors.push_back(std::move(row));
+                }
+                sink = vectors.size();
+            }
+            strategy.recycle();
+        }
+        return iterations;
+    }
+};
+
+struct result {
+    double seconds = 0;
+    std::size_t operations = 0;
+    call_counts calls;
+    long peak_rss_kib = 0;
+};
+
+template <typename Strategy, typename Lifecycle>
+result run_threads(unsigned threads, std::size_t iterations) {
+    std::atomic<unsigned> ready{0};
+    std::atomic<std::size_t> operations{0};
+    std::atomic<std::size_t> allocate_calls{0};
+    std::atomic<std::size_t> deallocate_calls{0};
+    std::atomic<std::size_t> reallocate_calls{0};
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned thread = 0; thread < threads; thread++) {
+        workers.emplace_back([&] {
+            Strategy strategy;
+            ready++;
+            while (ready.load() < threads) {
+                std::this_thread::yield();
+            }
+            operations += Lifecycle::run(strategy, iterations);
+            allocate_calls += thread_calls.allocate;
+            deallocate_calls += thread_calls.deallocate;
+            reallocate_calls += thread_calls.reallocate;
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    auto finish = std::chrono::steady_clock::now();
+    result measured;
+    measured.seconds = std::chrono::duration<double>(finish - start).count();
+    measured.operations = operations.load();
+    measured.calls = {allocate_calls.load(), deallocate_calls.load(),
+                      reallocate_calls.load()};
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    measured.peak_rss_kib = usage.ru_maxrss;
+    return measured;
+}
+
+class Reporter {
+    bool first_ = true;
+
+public:
+    Reporter() {
+        std::printf("{\n  \"benchmarks\": [");
+    }
+    Reporter(const Reporter &) = delete;
+    Reporter &operator=(const Reporter &) = delete;
+    ~Reporter() {
+        std::printf("\n  ]\n}\n");
+    }
+
+    void report(const char *allocator,
+                const char *lifecycle,
+                unsigned threads,
+                const result &measured) {
+        std::printf(
+            "%s\n    {\"allocator\": \"%s\", \"lifecycle\": \"%s\", "
+            "\"threads\": %u, \"ops_per_sec\": %.0f, \"peak_rss_kib\": %ld, "
+            "\"allocate_calls\": %zu, \"deallocate_calls\": %zu, "
+            "\"reallocate_calls\": %zu}",
+            first_ ? "" : ",", allocator, lifecycle, threads,
+            static_cast<double>(measured.operations) / measured.seconds,
+            measured.peak_rss_kib, measured.calls.allocate,
+            measured.calls.deallocate, measured.calls.reallocate);
+        first_ = false;
+    }
+};
+
+// Runs one configuration in a child process and reads back its result.
+template <typename Strategy, typename Lifecycle>
+void run_isolated(Reporter &reporter,
+                  const char *allocator,
+                  unsigned threads,
+                  std::size_t iterations) {
+    int channel[2];
+    if (pipe(channel) != 0) {
+        std::perror("pipe");
+        std::exit(1);
+    }
+    std::fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+        std::perror("fork");
+        std::exit(1);
+    }
+    if (child == 0) {
+        close(channel[0]);
+        result measured = run_threads<Strategy, Lifecycle>(threads, iterations);
+        ssize_t written = write(channel[1], &measured, sizeof(measured));
+        _exit(written == sizeof(measured) ? 0 : 1);
+    }
+    close(channel[1]);
+    result measured;
+    ssize_t got = read(channel[0], &measured, sizeof(measured));
+    close(channel[0]);
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (got != sizeof(measured) || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+        std::fprintf(stderr, "%s/%s on %u threads failed\n", allocator,
+                     Lifecycle::name, threads);
+        return;
+    }
+    reporter.report(allocator, Lifecycle::name, threads, measured);
+}
+
+template <typename Strategy>
+void run_allocator(Reporter &reporter,
+                   const char *allocator,
+                   unsigned max_threads,
+                   std::size_t iterations) {
+    for (unsigned threads = 1;; threads = std::min(threads * 2, max_threads)) {
+        run_isolated<Strategy, build_and_discard>(reporter, allocator,
+                                                  threads, iterations);
+        run_isolated<Strategy, long_lived_growth>(reporter, allocator,
+                                                  threads, iterations);
+        run_isolated<Strategy, many_small_vectors>(reporter, allocator,
+                                                   threads, iterations);
+        run_isolated<Strategy, vector_of_vectors>(reporter, allocator,
+                                                  threads, iterations);
+        if (threads == max_threads) {
+            break;
+        }
+    }
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+    unsigned max_threads = std::max(1U, std::thread::hardware_concurrency());
+    std::size_t iterations = 1'000;
+    for (int index = 1; index + 1 < argc; index += 2) {
+        unsigned long value = std::strtoul(argv[index + 1], nullptr, 10);
+        if (std::strcmp(argv[index], "--threads") == 0) {
+            max_threads = static_cast<unsigned>(std::max(1UL, value));
+        } else if (std::strcmp(argv[index], "--iterations") == 0) {
+            iterations = std::max(1UL, value);
+        } else {
+            std::fprintf(stderr, "usage: %s [--threads N] [--iterations K]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+
+    Reporter reporter;
+    run_allocator<stateless_strategy<std::allocator>>(
+        reporter, "std::allocator", max_threads, iterations);
+    run_allocator<stateless_strategy<counting_allocator>>(
+        reporter, "counting_allocator", max_threads, iterations);
+    run_allocator<stateless_strategy<lab_07::malloc_allocator>>(
+        reporter, "malloc_allocator", max_threads, iterations);
+    run_allocator<stateless_strategy<lab_07::caching_allocator>>(
+        reporter, "caching_allocator", max_threads, iterations);
+    run_allocator<stateless_strategy<mmap_allocator>>(
+        reporter, "mmap_allocator", max_threads, iterations);
+    run_allocator<arena_strategy>(reporter, "arena_allocator", max_threads,
+                                  iterations);
+    run_allocator<pool_strategy>(reporter, "pmr::unsynchronized_pool_resource",
+                                 max_threads, iterations);
+}
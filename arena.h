@@ -0,0 +1,205 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace lab_07 {
+// Monotonic memory resource: allocations bump a pointer through a chain of
+// blocks and are released all at once by reset() or destruction. Freeing
+// the most recent allocation gives its bytes back, and the most recent
+// allocation can grow in place, so a vector that is alone in an arena keeps
+// reusing the tail of the current block.
+class arena : public std::pmr::memory_resource {
+    struct block {
+        block *next;
+        std::size_t size;
+    };
+
+    static constexpr std::size_t block_header =
+        (sizeof(block) + alignof(std::max_align_t) - 1) /
+        alignof(std::max_align_t) * alignof(std::max_align_t);
+
+    block *blocks_ = nullptr;
+    char *cursor_ = nullptr;
+    char *end_ = nullptr;
+    char *last_allocation_ = nullptr;
+    std::size_t next_block_size_;
+    std::size_t reserved_bytes_ = 0;
+
+    void add_block(std::size_t min_bytes) {
+        std::size_t size = std::max(next_block_size_, min_bytes + block_header);
+        auto *new_block = static_cast<block *>(::operator new(size));
+        new_block->next = blocks_;
+        new_block->size = size;
+        blocks_ = new_block;
+        cursor_ = reinterpret_cast<char *>(new_block) + block_header;
+        end_ = reinterpret_cast<char *>(new_block) + size;
+        reserved_bytes_ += size;
+        next_block_size_ = size * 2;
+    }
+
+    static char *align_up(char *pointer, std::size_t alignment) noexcept {
+        auto address = reinterpret_cast<std::uintptr_t>(pointer);
+        return pointer + (alignment - address % alignment) % alignment;
+    }
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        char *result = align_up(cursor_, alignment);
+        // Aligning can step past a block end that is not itself aligned.
+        if (cursor_ == nullptr || result > end_ ||
+            static_cast<std::size_t>(end_ - result) < bytes) {
+            add_block(bytes + alignment);
+            result = align_up(cursor_, alignment);
+        }
+        cursor_ = result + bytes;
+        last_allocation_ = result;
+        return result;
+    }
+
+    void do_deallocate(void *pointer,
+                       std::size_t bytes,
+                       std::size_t) noexcept override {
+        if (pointer == last_allocation_ &&
+            last_allocation_ + bytes == cursor_) {
+            cursor_ = last_allocation_;
+            last_allocation_ = nullptr;
+        }
+    }
+
+    [[nodiscard]] bool do_is_equal(
+        const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    explicit arena(std::size_t initial_block_size = 64 * 1024) noexcept
+        : next_block_size_(initial_block_size) {
+    }
+
+    arena(const arena &) = delete;
+    arena &operator=(const arena &) = delete;
+
+    ~arena() override {
+        release();
+    }
+
+    // Grows the most recent allocation in place if the current block has
+    // room for it.
+    [[nodiscard]] bool try_extend(void *pointer,
+                                  std::size_t old_bytes,
+                                  std::size_t new_bytes) noexcept {
+        if (pointer != last_allocation_ ||
+            last_allocation_ + old_bytes != cursor_ ||
+            static_cast<std::size_t>(end_ - last_allocation_) < new_bytes) {
+            return false;
+        }
+        cursor_ = last_allocation_ + new_bytes;
+        return true;
+    }
+
+    // Frees every allocation at once, keeping the newest block for reuse.
+    void reset() noexcept {
+        if (blocks_ == nullptr) {
+            return;
+        }
+        block *kept = blocks_;
+        blocks_ = blocks_->next;
+        release();
+        kept->next = nullptr;
+        blocks_ = kept;
+        reserved_bytes_ = kept->size;
+        cursor_ = reinterpret_cast<char *>(kept) + block_header;
+        end_ = reinterpret_cast<char *>(kept) + kept->size;
+    }
+
+    // Frees every allocation and every block.
+    void release() noexcept {
+        while (blocks_ != nullptr) {
+            ::operator delete(std::exchange(blocks_, blocks_->next));
+        }
+        cursor_ = nullptr;
+        end_ = nullptr;
+        last_allocation_ = nullptr;
+        reserved_bytes_ = 0;
+    }
+
+    // Total size of the blocks currently obtained from the global heap.
+    [[nodiscard]] std::size_t reserved_bytes() const noexcept {
+        return reserved_bytes_;
+    }
+};
+
+// Allocator handing out memory from an arena. Deallocation only returns the
+// most recent allocation to the arena; everything else is freed in bulk by
+// arena::reset().
+template <typename T>
+class arena_allocator {
+    arena *arena_;
+
+    template <typename U>
+    friend class arena_allocator;
+
+public:
+    using value_type = T;
+
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    arena_allocator(arena &source) noexcept : arena_(&source) {
+    }
+
+    template <typename U>
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    arena_allocator(const arena_allocator<U> &other) noexcept
+        : arena_(other.arena_) {
+    }
+
+    T *allocate(std::size_t count) {
+        if (count > std::size_t(-1) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T *>(
+            arena_->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *pointer, std::size_t count) noexcept {
+        arena_->deallocate(pointer, count * sizeof(T), alignof(T));
+    }
+
+    // Grows in place when `pointer` is the newest allocation of the arena;
+    // otherwise copies into a new allocation and leaves the old bytes to the
+    // next reset().
+    T *reallocate(T *pointer, std::size_t old_count, std::size_t new_count) {
+        if (arena_->try_extend(pointer, old_count * sizeof(T),
+                               new_count * sizeof(T))) {
+            return pointer;
+        }
+        T *result = allocate(new_count);
+        std::memcpy(static_cast<void *>(result), static_cast<void *>(pointer),
+                    std::min(old_count, new_count) * sizeof(T));
+        return result;
+    }
+
+    [[nodiscard]] arena &resource() const noexcept {
+        return *arena_;
+    }
+
+    template <typename U>
+    bool operator==(const arena_allocator<U> &other) const noexcept {
+        return arena_ == other.arena_;
+    }
+
+    template <typename U>
+    bool operator!=(const arena_allocator<U> &other) const noexcept {
+        return arena_ != other.arena_;
+    }
+};
+
+}  // namespace lab_07
+
+#endif  // ARENA_H_
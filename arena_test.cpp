@@ -0,0 +1,110 @@
+#include "arena.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include "doctest.h"
+#include "vector.h"
+
+TEST_CASE("arena_allocator grows the newest buffer in place") {
+    lab_07::arena arena(64 * 1024);
+    lab_07::vector<int, lab_07::arena_allocator<int>> v{
+        lab_07::arena_allocator<int>(arena)};
+    for (int i = 0; i < 5'000; i++) {
+        v.push_back(int{i});
+    }
+    REQUIRE(v.size() == 5'000);
+    for (int i = 0; i < 5'000; i++) {
+        REQUIRE(v[i] == i);
+    }
+    CHECK(arena.reserved_bytes() == 64 * 1024);
+}
+
+TEST_CASE("arena_allocator leaves old buffers to reset") {
+    lab_07::arena arena(1024);
+    {
+        lab_07::vector<std::string, lab_07::arena_allocator<std::string>> v{
+            lab_07::arena_allocator<std::string>(arena)};
+        for (int i = 0; i < 1'000; i++) {
+            v.push_back(std::to_string(i));
+        }
+        CHECK(v[0] == "0");
+        CHECK(v[999] == "999");
+
+        lab_07::vector<std::string, lab_07::arena_allocator<std::string>>
+            copy = v;
+        CHECK(copy.get_allocator() == v.get_allocator());
+        CHECK(copy[999] == "999");
+    }
+    std::size_t reserved = arena.reserved_bytes();
+    CHECK(reserved > 1'000 * sizeof(std::string));
+    arena.reset();
+    CHECK(arena.reserved_bytes() <= reserved);
+    CHECK(arena.reserved_bytes() > 0);
+
+    lab_07::vector<int, lab_07::arena_allocator<int>> v(
+        100, lab_07::arena_allocator<int>(arena));
+    CHECK(v[99] == 0);
+    arena.release();
+    CHECK(arena.reserved_bytes() == 0);
+}
+
+TEST_CASE("pmr::vector uses its memory resource") {
+    lab_07::arena arena;
+    lab_07::pmr::vector<std::string> v(&arena);
+    v.resize(100, std::string(100U, 'a'));
+    CHECK(v.get_allocator().resource() == &arena);
+    CHECK(arena.reserved_bytes() > 0);
+
+    SUBCASE("copy uses the default resource") {
+        lab_07::pmr::vector<std::string> copy = v;
+        CHECK(copy.get_allocator().resource() ==
+              std::pmr::get_default_resource());
+        CHECK(copy[99] == std::string(100U, 'a'));
+    }
+
+    SUBCASE("copy assignment keeps the target resource") {
+        std::pmr::monotonic_buffer_resource other_resource;
+        lab_07::pmr::vector<std::string> target(3, std::string("x"),
+                                                &other_resource);
+        target = v;
+        CHECK(target.get_allocator().resource() == &other_resource);
+        REQUIRE(target.size() == 100);
+        CHECK(target[99] == std::string(100U, 'a'));
+    }
+
+    SUBCASE("move assignment across resources moves elements") {
+        std::pmr::monotonic_buffer_resource other_resource;
+        lab_07::pmr::vector<std::string> target(&other_resource);
+        target.push_back(std::string("x"));
+        target = std::move(v);
+        CHECK(target.get_allocator().resource() == &other_resource);
+        REQUIRE(target.size() == 100);
+        CHECK(target[99] == std::string(100U, 'a'));
+        // NOLINTNEXTLINE(bugprone-use-after-move)
+        CHECK(v.empty());
+    }
+
+    SUBCASE("move assignment within a resource steals the buffer") {
+        lab_07::pmr::vector<std::string> target(&arena);
+        const std::string *buffer = &v[0];
+        target = std::move(v);
+        CHECK(&target[0] == buffer);
+    }
+}
+
+TEST_CASE("arena aligns allocations within a misaligned block end") {
+    lab_07::arena arena(64);
+    static_cast<void>(arena.allocate(101, 1));
+    std::size_t reserved = arena.reserved_bytes();
+    REQUIRE(reserved % 8 != 0);
+
+    void *pointer = arena.allocate(1, 8);
+    CHECK(reinterpret_cast<std::uintptr_t>(pointer) % 8 == 0);
+    CHECK(arena.reserved_bytes() > reserved);
+    *static_cast<char *>(pointer) = 1;
+
+    void *wide = arena.allocate(16, 16);
+    CHECK(reinterpret_cast<std::uintptr_t>(wide) % 16 == 0);
+    static_cast<char *>(wide)[15] = 1;
+}
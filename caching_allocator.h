@@ -0,0 +1,260 @@
+#ifndef CACHING_ALLOCATOR_H_
+#define CACHING_ALLOCATOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <new>
+
+namespace lab_07 {
+struct buffer_cache_stats {
+    std::size_t heap_allocations = 0;
+    std::size_t heap_deallocations = 0;
+};
+
+namespace detail {
+// Buffers are grouped in power-of-two size classes, which is all a vector
+// ever asks for when sizeof(T) is a power of two.
+class buffer_cache {
+public:
+    static constexpr std::size_t min_class = 4;
+    static constexpr std::size_t max_class = 26;
+    static constexpr std::size_t thread_slots = 16;
+    static constexpr std::size_t depot_slots = 64;
+    // A thread cache returns buffers it has not needed for this many
+    // operations to the depot.
+    static constexpr std::size_t trim_interval = 4096;
+
+private:
+    static constexpr std::size_t classes = max_class + 1;
+
+    struct depot {
+        std::mutex mutex;
+        void *slots[classes][depot_slots]{};
+        std::size_t counts[classes]{};
+    };
+
+    struct thread_cache {
+        void *slots[classes][thread_slots]{};
+        std::size_t counts[classes]{};
+        // Minimum of counts[] since the last trim: buffers that stayed idle.
+        std::size_t low_watermarks[classes]{};
+        std::size_t operations = 0;
+
+        thread_cache() = default;
+        thread_cache(const thread_cache &) = delete;
+        thread_cache &operator=(const thread_cache &) = delete;
+
+        ~thread_cache() {
+            for (std::size_t size_class = 0; size_class < classes;
+                 size_class++) {
+                flush(size_class, counts[size_class]);
+            }
+        }
+
+        // Moves the `count` most recently cached buffers to the depot.
+        void flush(std::size_t size_class, std::size_t count) noexcept {
+            depot &shared = global_depot();
+            std::lock_guard lock(shared.mutex);
+            for (; count > 0; count--) {
+                void *buffer = slots[size_class][--counts[size_class]];
+                if (shared.counts[size_class] < depot_slots) {
+                    shared.slots[size_class][shared.counts[size_class]++] =
+                        buffer;
+                } else {
+                    heap_deallocate(buffer);
+                }
+            }
+            low_watermarks[size_class] =
+                std::min(low_watermarks[size_class], counts[size_class]);
+        }
+
+        // Refills half of the slots of `size_class` from the depot.
+        void refill(std::size_t size_class) noexcept {
+            depot &shared = global_depot();
+            std::lock_guard lock(shared.mutex);
+            while (counts[size_class] < thread_slots / 2 &&
+                   shared.counts[size_class] > 0) {
+                slots[size_class][counts[size_class]++] =
+                    shared.slots[size_class][--shared.counts[size_class]];
+            }
+        }
+
+        void tick() noexcept {
+            if (++operations < trim_interval) {
+                return;
+            }
+            operations = 0;
+            for (std::size_t size_class = 0; size_class < classes;
+                 size_class++) {
+                if (low_watermarks[size_class] > 0) {
+                    flush(size_class, low_watermarks[size_class]);
+                }
+                low_watermarks[size_class] = counts[size_class];
+            }
+        }
+    };
+
+    static depot &global_depot() noexcept {
+        // Never destroyed: thread caches may flush into it during exit.
+        static depot *instance = new depot;
+        return *instance;
+    }
+
+    static thread_cache &local_cache() noexcept {
+        thread_local thread_cache cache;
+        return cache;
+    }
+
+    static std::atomic<std::size_t> &heap_allocations() noexcept {
+        static std::atomic<std::size_t> counter{0};
+        return counter;
+    }
+
+    static std::atomic<std::size_t> &heap_deallocations() noexcept {
+        static std::atomic<std::size_t> counter{0};
+        return counter;
+    }
+
+    static void *heap_allocate(std::size_t bytes) {
+        void *result = ::operator new(bytes);
+        heap_allocations().fetch_add(1, std::memory_order_relaxed);
+        return result;
+    }
+
+    static void heap_deallocate(void *buffer) noexcept {
+        ::operator delete(buffer);
+        heap_deallocations().fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static std::size_t size_class(std::size_t bytes) noexcept {
+        std::size_t result = min_class;
+        while ((std::size_t{1} << result) < bytes && result <= max_class) {
+            result++;
+        }
+        return result;
+    }
+
+public:
+    static void *allocate(std::size_t bytes) {
+        std::size_t cls = size_class(bytes);
+        if (cls > max_class) {
+            return heap_allocate(bytes);
+        }
+        thread_cache &cache = local_cache();
+        cache.tick();
+        if (cache.counts[cls] == 0) {
+            cache.refill(cls);
+        }
+        if (cache.counts[cls] == 0) {
+            return heap_allocate(std::size_t{1} << cls);
+        }
+        void *result = cache.slots[cls][--cache.counts[cls]];
+        cache.low_watermarks[cls] =
+            std::min(cache.low_watermarks[cls], cache.counts[cls]);
+        return result;
+    }
+
+    static void deallocate(void *buffer, std::size_t bytes) noexcept {
+        std::size_t cls = size_class(bytes);
+        if (cls > max_class) {
+            heap_deallocate(buffer);
+            return;
+        }
+        thread_cache &cache = local_cache();
+        cache.tick();
+        if (cache.counts[cls] == thread_slots) {
+            cache.flush(cls, thread_slots / 2);
+        }
+        cache.slots[cls][cache.counts[cls]++] = buffer;
+    }
+
+    // Returns every buffer cached by the calling thread to the depot.
+    static void trim_thread() noexcept {
+        thread_cache &cache = local_cache();
+        for (std::size_t cls = 0; cls < classes; cls++) {
+            cache.flush(cls, cache.counts[cls]);
+        }
+    }
+
+    // Frees every buffer held by the depot.
+    static void trim_depot() noexcept {
+        depot &shared = global_depot();
+        std::lock_guard lock(shared.mutex);
+        for (std::size_t cls = 0; cls < classes; cls++) {
+            while (shared.counts[cls] > 0) {
+                heap_deallocate(shared.slots[cls][--shared.counts[cls]]);
+            }
+        }
+    }
+
+    static buffer_cache_stats stats() noexcept {
+        return buffer_cache_stats{
+            heap_allocations().load(std::memory_order_relaxed),
+            heap_deallocations().load(std::memory_order_relaxed)};
+    }
+};
+}  // namespace detail
+
+// Stateless allocator recycling buffers through per-thread free lists keyed
+// by log2 of the buffer size, backed by a bounded shared depot that also
+// takes buffers freed by other threads. Requests above 2^max_class bytes go
+// straight to the global heap.
+template <typename T>
+struct caching_allocator {
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+    using value_type = T;
+
+    caching_allocator() noexcept = default;
+
+    template <typename U>
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    caching_allocator(const caching_allocator<U> &) noexcept {
+    }
+
+    T *allocate(std::size_t count) {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T *>(
+            detail::buffer_cache::allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t count) noexcept {
+        detail::buffer_cache::deallocate(ptr, count * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const caching_allocator<T> &,
+                const caching_allocator<U> &) noexcept {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const caching_allocator<T> &,
+                const caching_allocator<U> &) noexcept {
+    return false;
+}
+
+// Hands the buffers cached by the calling thread to the shared depot, e.g.
+// before the thread goes idle for a long time.
+inline void trim_thread_buffer_cache() noexcept {
+    detail::buffer_cache::trim_thread();
+}
+
+// Frees the buffers held by the shared depot.
+inline void trim_buffer_cache() noexcept {
+    detail::buffer_cache::trim_depot();
+}
+
+inline buffer_cache_stats buffer_cache_statistics() noexcept {
+    return detail::buffer_cache::stats();
+}
+
+}  // namespace lab_07
+
+#endif  // CACHING_ALLOCATOR_H_
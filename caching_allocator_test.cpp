@@ -0,0 +1,68 @@
+#include "caching_allocator.h"
+#include <cstddef>
+#include <string>
+#include <thread>
+#include "doctest.h"
+#include "vector.h"
+
+namespace {
+template <typename T>
+using caching_vector = lab_07::vector<T, lab_07::caching_allocator<T>>;
+
+void build_and_discard() {
+    caching_vector<int> ints;
+    caching_vector<std::string> strings;
+    for (int i = 0; i < 1'000; i++) {
+        ints.push_back(int{i});
+        strings.push_back(std::string(3U, 'x'));
+    }
+    REQUIRE(ints[999] == 999);
+    REQUIRE(strings[999] == "xxx");
+}
+}  // namespace
+
+TEST_CASE("caching_allocator recycles buffers of discarded vectors") {
+    build_and_discard();
+    lab_07::buffer_cache_stats before = lab_07::buffer_cache_statistics();
+    for (int step = 0; step < 100; step++) {
+        build_and_discard();
+    }
+    lab_07::buffer_cache_stats after = lab_07::buffer_cache_statistics();
+    CHECK(after.heap_allocations == before.heap_allocations);
+    CHECK(after.heap_deallocations == before.heap_deallocations);
+}
+
+TEST_CASE("caching_allocator takes buffers freed by other threads") {
+    caching_vector<int> v;
+    std::thread producer([&v] {
+        caching_vector<int> local(1'000, 5);
+        v = std::move(local);
+        lab_07::trim_thread_buffer_cache();
+    });
+    producer.join();
+    CHECK(v[999] == 5);
+    v = caching_vector<int>();
+    lab_07::trim_thread_buffer_cache();
+
+    lab_07::buffer_cache_stats before = lab_07::buffer_cache_statistics();
+    caching_vector<int> reused(1'000);
+    CHECK(lab_07::buffer_cache_statistics().heap_allocations ==
+          before.heap_allocations);
+
+    lab_07::trim_thread_buffer_cache();
+    lab_07::trim_buffer_cache();
+    CHECK(lab_07::buffer_cache_statistics().heap_deallocations >
+          before.heap_deallocations);
+}
+
+TEST_CASE("caching_allocator serves huge buffers from the heap") {
+    lab_07::buffer_cache_stats before = lab_07::buffer_cache_statistics();
+    {
+        caching_vector<char> v(
+            (std::size_t{1} << lab_07::detail::buffer_cache::max_class) + 1);
+        v[v.size() - 1] = 'x';
+    }
+    lab_07::buffer_cache_stats after = lab_07::buffer_cache_statistics();
+    CHECK(after.heap_allocations == before.heap_allocations + 1);
+    CHECK(after.heap_deallocations == before.heap_deallocations + 1);
+}
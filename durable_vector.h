@@ -0,0 +1,207 @@
+#ifndef DURABLE_VECTOR_H_
+#define DURABLE_VECTOR_H_
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "serialize.h"
+#include "vector.h"
+
+namespace lab_07 {
+// Append-only vector of records persisted in a file in the format written
+// by serialize(), so committed logs can also be read with deserialize() or
+// mapped_view. Appended records stay pending in memory until commit(); a
+// process that dies before commit() returns loses at most the pending
+// records, and reopening the file recovers the last committed length.
+//
+// commit() writes the pending records past the committed ones and syncs
+// them before it rewrites the header with the new count, so the header
+// never describes records that are not on disk. The 64-byte header is
+// updated with a single write within one disk sector.
+template <typename T>
+class durable_vector {
+    static_assert(std::is_trivially_copyable_v<T>);
+    int fd_ = -1;
+    vector<T> records_;
+    std::size_t committed_ = 0;
+    // Checksum of the committed records, extended on every commit.
+    detail::checksum checksum_;
+
+    static void sync(int fd) {
+        if (fdatasync(fd) != 0) {
+            detail::throw_errno("fdatasync");
+        }
+    }
+
+    // Makes a newly created file's directory entry durable.
+    static void sync_directory(const std::string &path) {
+        std::size_t slash = path.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "."
+                                : slash == 0 ? "/"
+                                             : path.substr(0, slash);
+        int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            detail::throw_errno("open");
+        }
+        int result = fsync(fd);
+        close(fd);
+        if (result != 0) {
+            detail::throw_errno("fsync");
+        }
+    }
+
+    void write_header(std::size_t count, std::uint64_t checksum) {
+        serialized_header header = detail::make_header(
+            serialized_header::raw_payload, sizeof(T), count);
+        header.payload_bytes = count * sizeof(T);
+        header.checksum = checksum;
+        detail::pwrite_all(fd_, &header, sizeof(header), 0);
+        sync(fd_);
+    }
+
+    void open_log(const std::string &path) {
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            detail::throw_errno("open");
+        }
+        struct stat file_stat {};
+        if (fstat(fd_, &file_stat) != 0) {
+            detail::throw_errno("fstat");
+        }
+        if (file_stat.st_size == 0) {
+            write_header(0, checksum_.value());
+            sync_directory(path);
+            return;
+        }
+        records_ = deserialize<T>(fd_);
+        committed_ = records_.size();
+        checksum_.update(records_.data(), committed_ * sizeof(T));
+        // Drops records written by a commit that did not complete.
+        auto committed_bytes = static_cast<off_t>(sizeof(serialized_header) +
+                                                  committed_ * sizeof(T));
+        if (file_stat.st_size > committed_bytes) {
+            if (ftruncate(fd_, committed_bytes) != 0) {
+                detail::throw_errno("ftruncate");
+            }
+            sync(fd_);
+        }
+    }
+
+public:
+    using value_type = T;
+
+    // Opens the log at `path`, creating it if it does not exist, and loads
+    // its committed records.
+    explicit durable_vector(const std::string &path) {
+        try {
+            open_log(path);
+        } catch (...) {
+            if (fd_ >= 0) {
+                close(fd_);
+            }
+            throw;
+        }
+    }
+
+    durable_vector(const durable_vector &) = delete;
+    durable_vector &operator=(const durable_vector &) = delete;
+
+    durable_vector(durable_vector &&other) noexcept
+        : fd_(std::exchange(other.fd_, -1)),
+          records_(std::move(other.records_)),
+          committed_(std::exchange(other.committed_, 0)),
+          checksum_(other.checksum_) {
+    }
+
+    durable_vector &operator=(durable_vector &&other) noexcept {
+        if (this != &other) {
+            if (fd_ >= 0) {
+                close(fd_);
+            }
+            fd_ = std::exchange(other.fd_, -1);
+            records_ = std::move(other.records_);
+            committed_ = std::exchange(other.committed_, 0);
+            checksum_ = other.checksum_;
+        }
+        return *this;
+    }
+
+    // Closes the file; pending records are discarded.
+    ~durable_vector() noexcept {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    void push_back(const T &record) & {
+        records_.push_back(record);
+    }
+
+    void reserve(std::size_t quantity) & {
+        records_.reserve(quantity);
+    }
+
+    // Makes every pending record durable with two syncs, however many
+    // records were appended since the last commit.
+    void commit() {
+        if (records_.size() == committed_) {
+            return;
+        }
+        std::size_t pending = records_.size() - committed_;
+        detail::pwrite_all(fd_, records_.data() + committed_,
+                           pending * sizeof(T),
+                           sizeof(serialized_header) + committed_ * sizeof(T));
+        sync(fd_);
+        detail::checksum extended = checksum_;
+        extended.update(records_.data() + committed_, pending * sizeof(T));
+        write_header(records_.size(), extended.value());
+        checksum_ = extended;
+        committed_ = records_.size();
+    }
+
+    // Drops the records appended since the last commit.
+    void discard_pending() &noexcept {
+        while (records_.size() > committed_) {
+            records_.pop_back();
+        }
+    }
+
+    [[nodiscard]] const T &operator[](std::size_t index) const noexcept {
+        return records_[index];
+    }
+
+    [[nodiscard]] const T &at(std::size_t index) const {
+        return records_.at(index);
+    }
+
+    [[nodiscard]] const T *data() const noexcept {
+        return records_.data();
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return records_.empty();
+    }
+
+    // Number of records, committed or not.
+    [[nodiscard]] std::size_t size() const noexcept {
+        return records_.size();
+    }
+
+    [[nodiscard]] std::size_t committed_size() const noexcept {
+        return committed_;
+    }
+
+    [[nodiscard]] std::size_t pending_size() const noexcept {
+        return records_.size() - committed_;
+    }
+};
+
+}  // namespace lab_07
+
+#endif  // DURABLE_VECTOR_H_
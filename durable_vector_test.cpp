@@ -0,0 +1,91 @@
+#include "durable_vector.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include "doctest.h"
+#include "mapped_view.h"
+#include "serialize.h"
+#include "test_temporary_file.h"
+
+namespace {
+struct Record {
+    std::uint64_t id;
+    double amount;
+};
+
+off_t file_size(int fd) {
+    struct stat file_stat {};
+    REQUIRE(fstat(fd, &file_stat) == 0);
+    return file_stat.st_size;
+}
+}  // namespace
+
+TEST_CASE("durable_vector keeps committed records across reopening") {
+    TemporaryFile file;
+    {
+        lab_07::durable_vector<Record> log(file.path());
+        CHECK(log.empty());
+        for (std::uint64_t i = 0; i < 1'000; i++) {
+            log.push_back(Record{i, static_cast<double>(i) / 2});
+        }
+        CHECK(log.pending_size() == 1'000);
+        log.commit();
+        CHECK(log.committed_size() == 1'000);
+        CHECK(log.pending_size() == 0);
+        log.push_back(Record{1'000, 0});
+        CHECK(log.size() == 1'001);
+        CHECK(log[1'000].id == 1'000);
+    }
+
+    lab_07::durable_vector<Record> log(file.path());
+    REQUIRE(log.size() == 1'000);
+    CHECK(log.committed_size() == 1'000);
+    CHECK(log[999].id == 999);
+    CHECK(log.at(10).amount == 5.0);
+
+    log.push_back(Record{1'000, 1});
+    log.push_back(Record{1'001, 2});
+    log.discard_pending();
+    CHECK(log.size() == 1'000);
+    log.push_back(Record{1'000, 3});
+    log.commit();
+
+    lab_07::mapped_view<Record> view(file.path());
+    REQUIRE(view.size() == 1'001);
+    CHECK(view[1'000].amount == 3.0);
+    CHECK(view.verify_checksum());
+}
+
+TEST_CASE("durable_vector recovers from an interrupted commit") {
+    TemporaryFile file;
+    {
+        lab_07::durable_vector<Record> log(file.path());
+        log.push_back(Record{1, 1});
+        log.push_back(Record{2, 2});
+        log.commit();
+    }
+    // Records written by a commit that never updated the header.
+    Record torn[3] = {{3, 3}, {4, 4}, {5, 5}};
+    off_t committed_bytes = file_size(file.fd());
+    REQUIRE(pwrite(file.fd(), torn, sizeof(torn), committed_bytes) ==
+            sizeof(torn));
+
+    lab_07::durable_vector<Record> log(file.path());
+    CHECK(log.size() == 2);
+    CHECK(log[1].id == 2);
+    CHECK(file_size(file.fd()) == committed_bytes);
+
+    log.push_back(Record{3, 3});
+    log.commit();
+    file.rewind();
+    auto records = lab_07::deserialize<Record>(file.fd());
+    REQUIRE(records.size() == 3);
+    CHECK(records[2].id == 3);
+}
+
+TEST_CASE("durable_vector rejects files of another element type") {
+    TemporaryFile file;
+    lab_07::serialize(file.fd(), lab_07::vector<std::int32_t>(4));
+    CHECK_THROWS_AS(lab_07::durable_vector<Record>(file.path()),
+                    lab_07::serialization_error);
+}
@@ -0,0 +1,27 @@
+#ifndef EXCEPTIONS_H_
+#define EXCEPTIONS_H_
+
+#include <cstdlib>
+
+// Builds without exception support (-fno-exceptions, or LAB_07_NO_EXCEPTIONS
+// defined) turn try blocks into plain blocks, never enter catch blocks and
+// abort where an exception would be thrown. The try_* members of vector
+// report running out of memory instead.
+#if !defined(LAB_07_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && \
+    !defined(_CPPUNWIND)
+#define LAB_07_NO_EXCEPTIONS
+#endif
+
+#ifdef LAB_07_NO_EXCEPTIONS
+#define LAB_07_TRY if (true)
+#define LAB_07_CATCH(declaration) if (false)
+#define LAB_07_RETHROW std::abort()
+#define LAB_07_THROW(exception) std::abort()
+#else
+#define LAB_07_TRY try
+#define LAB_07_CATCH(declaration) catch (declaration)
+#define LAB_07_RETHROW throw
+#define LAB_07_THROW(exception) throw exception
+#endif
+
+#endif  // EXCEPTIONS_H_
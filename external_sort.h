@@ -0,0 +1,581 @@
+#ifndef EXTERNAL_SORT_H_
+#define EXTERNAL_SORT_H_
+
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "parallel.h"
+#include "serialize.h"
+
+namespace lab_07 {
+struct external_sort_stats {
+    std::size_t runs = 0;
+    // Merge passes over the data, the last one writing the output.
+    std::size_t merge_passes = 0;
+};
+
+namespace detail {
+// Uninitialized storage for `count` trivially copyable elements.
+template <typename T>
+class raw_buffer {
+    struct free_buffer {
+        void operator()(T *data) const noexcept {
+            ::operator delete(data);
+        }
+    };
+
+    std::unique_ptr<T, free_buffer> data_;
+
+public:
+    explicit raw_buffer(std::size_t count)
+        : data_(static_cast<T *>(::operator new(count * sizeof(T)))) {
+    }
+
+    [[nodiscard]] T *get() const noexcept {
+        return data_.get();
+    }
+};
+
+inline void rethrow_first(const std::exception_ptr *errors, std::size_t count) {
+    for (std::size_t index = 0; index < count; index++) {
+        if (errors[index] != nullptr) {
+            std::rethrow_exception(errors[index]);
+        }
+    }
+}
+
+// Merges the sorted ranges [first, middle) and [middle, last) through
+// `scratch`, which holds the shorter of the two.
+template <typename T, typename Compare>
+void merge_through(T *first, T *middle, T *last, T *scratch,
+                   const Compare &comp) {
+    if (middle - first <= last - middle) {
+        T *scratch_end = std::copy(first, middle, scratch);
+        T *left = scratch;
+        T *right = middle;
+        T *out = first;
+        while (left != scratch_end && right != last) {
+            *out++ = comp(*right, *left) ? *right++ : *left++;
+        }
+        std::copy(left, scratch_end, out);
+    } else {
+        T *scratch_end = std::copy(middle, last, scratch);
+        T *left = middle;
+        T *right = scratch_end;
+        T *out = last;
+        while (left != first && right != scratch) {
+            *--out = comp(*(right - 1), *(left - 1)) ? *--left : *--right;
+        }
+        std::copy_backward(scratch, right, out);
+    }
+}
+
+// Sorts chunks of [first, first + count) on the thread pool, then merges
+// pairs of neighbouring chunks in parallel until one is left. The merges
+// use `scratch`, room for count / 2 elements, instead of allocating.
+template <typename T, typename Compare>
+void parallel_sort(T *first,
+                   std::size_t count,
+                   T *scratch,
+                   const Compare &comp) {
+    constexpr std::size_t min_chunk = 4096;
+    unsigned threads = parallel_thread_count();
+    std::size_t chunks = std::clamp<std::size_t>(count / min_chunk, 1, threads);
+    auto errors = std::make_unique<std::exception_ptr[]>(chunks);
+    auto bound = [&](std::size_t chunk) {
+        return chunk == chunks ? count
+                               : chunk_bounds(0, count, chunk, chunks).first;
+    };
+    thread_pool::instance().run(chunks, threads, [&](std::size_t chunk) {
+        try {
+            std::sort(first + bound(chunk), first + bound(chunk + 1), comp);
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    });
+    rethrow_first(errors.get(), chunks);
+    for (std::size_t width = 1; width < chunks; width *= 2) {
+        std::size_t merges = (chunks + 2 * width - 1) / (2 * width);
+        thread_pool::instance().run(merges, threads, [&](std::size_t merge) {
+            std::size_t left = merge * 2 * width;
+            std::size_t middle = std::min(left + width, chunks);
+            std::size_t right = std::min(left + 2 * width, chunks);
+            // The shorter side of each merge fits in its share of scratch.
+            try {
+                merge_through(first + bound(left), first + bound(middle),
+                              first + bound(right), scratch + bound(left) / 2,
+                              comp);
+            } catch (...) {
+                errors[merge] = std::current_exception();
+            }
+        });
+        rethrow_first(errors.get(), merges);
+    }
+}
+
+// One background thread running the reads and writes of an external sort
+// in submission order, so they overlap sorting and merging.
+class io_thread {
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::packaged_task<void()>> jobs_;
+    bool stop_ = false;
+    std::thread thread_;
+
+    void work() {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] { return stop_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            std::packaged_task<void()> job = std::move(jobs_.front());
+            jobs_.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+public:
+    io_thread() : thread_([this] { work(); }) {
+    }
+
+    io_thread(const io_thread &) = delete;
+    io_thread &operator=(const io_thread &) = delete;
+
+    ~io_thread() noexcept {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        thread_.join();
+    }
+
+    std::future<void> submit(std::function<void()> job) {
+        std::packaged_task<void()> task(std::move(job));
+        std::future<void> result = task.get_future();
+        {
+            std::lock_guard lock(mutex_);
+            jobs_.push_back(std::move(task));
+        }
+        wake_.notify_one();
+        return result;
+    }
+};
+
+struct sorted_run {
+    std::uint64_t offset;
+    std::size_t count;
+};
+
+// Reads a sorted run through two blocks: while the merge consumes one, the
+// next part of the run is read into the other.
+template <typename T>
+class run_reader {
+    int fd_;
+    io_thread *io_;
+    std::uint64_t offset_;
+    std::size_t remaining_;
+    T *blocks_[2];
+    std::size_t block_size_;
+    std::size_t current_ = 1;
+    std::size_t position_ = 0;
+    std::size_t loaded_ = 0;
+    std::size_t next_loaded_ = 0;
+    std::future<void> reading_;
+
+    void read_ahead() {
+        next_loaded_ = std::min(remaining_, block_size_);
+        if (next_loaded_ == 0) {
+            return;
+        }
+        int fd = fd_;
+        T *data = blocks_[current_ ^ 1];
+        std::size_t bytes = next_loaded_ * sizeof(T);
+        std::uint64_t offset = offset_;
+        reading_ = io_->submit(
+            [fd, data, bytes, offset] { pread_all(fd, data, bytes, offset); });
+        offset_ += bytes;
+        remaining_ -= next_loaded_;
+    }
+
+    void switch_blocks() {
+        reading_.get();
+        current_ ^= 1;
+        loaded_ = next_loaded_;
+        position_ = 0;
+        read_ahead();
+    }
+
+public:
+    // `blocks` holds two blocks of `block_size` elements.
+    run_reader(int fd,
+               sorted_run run,
+               T *blocks,
+               std::size_t block_size,
+               io_thread &io)
+        : fd_(fd),
+          io_(&io),
+          offset_(run.offset),
+          remaining_(run.count),
+          blocks_{blocks, blocks + block_size},
+          block_size_(block_size) {
+        read_ahead();
+        if (reading_.valid()) {
+            switch_blocks();
+        }
+    }
+
+    run_reader(run_reader &&) noexcept = default;
+    run_reader &operator=(run_reader &&) = delete;
+
+    // The read in flight writes into blocks owned by the caller.
+    ~run_reader() noexcept {
+        if (reading_.valid()) {
+            reading_.wait();
+        }
+    }
+
+    // Null once the run is exhausted.
+    [[nodiscard]] const T *head() const noexcept {
+        return position_ < loaded_ ? blocks_[current_] + position_ : nullptr;
+    }
+
+    void advance() {
+        if (++position_ == loaded_ && reading_.valid()) {
+            switch_blocks();
+        }
+    }
+};
+
+// Tournament tree over k sources: each inner node keeps the loser of the
+// match played there, so replacing the winner's head replays only the
+// log2(k) matches on its path. Ties go to the lower source.
+template <typename T, typename Compare>
+class loser_tree {
+    std::vector<run_reader<T>> &sources_;
+    const Compare &comp_;
+    // tree_[0] is the overall winner, tree_[1..k) the losers.
+    std::vector<std::size_t> tree_;
+
+    [[nodiscard]] bool beats(std::size_t a, std::size_t b) const {
+        const T *head_a = sources_[a].head();
+        const T *head_b = sources_[b].head();
+        if (head_b == nullptr) {
+            return head_a != nullptr || a < b;
+        }
+        if (head_a == nullptr) {
+            return false;
+        }
+        return comp_(*head_a, *head_b) || (!comp_(*head_b, *head_a) && a < b);
+    }
+
+public:
+    loser_tree(std::vector<run_reader<T>> &sources, const Compare &comp)
+        : sources_(sources), comp_(comp), tree_(sources.size()) {
+        std::size_t leaves = sources.size();
+        std::vector<std::size_t> winners(2 * leaves);
+        for (std::size_t leaf = 0; leaf < leaves; leaf++) {
+            winners[leaves + leaf] = leaf;
+        }
+        for (std::size_t node = leaves - 1; node > 0; node--) {
+            std::size_t left = winners[2 * node];
+            std::size_t right = winners[2 * node + 1];
+            bool left_wins = beats(left, right);
+            winners[node] = left_wins ? left : right;
+            tree_[node] = left_wins ? right : left;
+        }
+        tree_[0] = leaves == 1 ? 0 : winners[1];
+    }
+
+    [[nodiscard]] std::size_t winner() const noexcept {
+        return tree_[0];
+    }
+
+    // Replays the matches of the winner after its head changed.
+    void replay() {
+        std::size_t winner = tree_[0];
+        for (std::size_t node = (winner + tree_.size()) / 2; node > 0;
+             node /= 2) {
+            if (beats(tree_[node], winner)) {
+                std::swap(tree_[node], winner);
+            }
+        }
+        tree_[0] = winner;
+    }
+};
+
+// Writes elements through two buffers: one is written to the file by the
+// I/O thread while the other fills up.
+template <typename T>
+class double_buffered_writer {
+    int fd_;
+    io_thread *io_;
+    std::uint64_t offset_;
+    raw_buffer<T> buffers_;
+    std::size_t buffer_size_;
+    std::size_t current_ = 0;
+    std::size_t filled_ = 0;
+    std::future<void> pending_;
+    checksum checksum_;
+
+    void wait() {
+        if (pending_.valid()) {
+            pending_.get();
+        }
+    }
+
+public:
+    double_buffered_writer(int fd,
+                           std::uint64_t offset,
+                           std::size_t buffer_size,
+                           io_thread &io)
+        : fd_(fd),
+          io_(&io),
+          offset_(offset),
+          buffers_(2 * buffer_size),
+          buffer_size_(buffer_size) {
+    }
+
+    double_buffered_writer(const double_buffered_writer &) = delete;
+    double_buffered_writer &operator=(const double_buffered_writer &) = delete;
+
+    ~double_buffered_writer() noexcept {
+        if (pending_.valid()) {
+            pending_.wait();
+        }
+    }
+
+    void push(const T &element) {
+        new (buffers_.get() + current_ * buffer_size_ + filled_++) T(element);
+        if (filled_ == buffer_size_) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (filled_ == 0) {
+            return;
+        }
+        const T *data = buffers_.get() + current_ * buffer_size_;
+        std::size_t bytes = filled_ * sizeof(T);
+        checksum_.update(data, bytes);
+        wait();
+        int fd = fd_;
+        std::uint64_t offset = offset_;
+        pending_ = io_->submit(
+            [fd, data, bytes, offset] { pwrite_all(fd, data, bytes, offset); });
+        offset_ += bytes;
+        current_ ^= 1;
+        filled_ = 0;
+    }
+
+    // Writes out the buffered elements and waits for every write.
+    void finish() {
+        flush();
+        wait();
+    }
+
+    [[nodiscard]] std::uint64_t payload_checksum() const noexcept {
+        return checksum_.value();
+    }
+};
+
+// Merges the runs, giving each `block_size` elements split into two blocks.
+template <typename T, typename Compare>
+void merge_runs(int fd,
+                const sorted_run *runs,
+                std::size_t run_count,
+                std::size_t block_size,
+                double_buffered_writer<T> &output,
+                io_thread &io,
+                const Compare &comp) {
+    std::size_t half = std::max<std::size_t>(1, block_size / 2);
+    raw_buffer<T> blocks(run_count * 2 * half);
+    std::vector<run_reader<T>> sources;
+    sources.reserve(run_count);
+    for (std::size_t run = 0; run < run_count; run++) {
+        sources.emplace_back(fd, runs[run], blocks.get() + run * 2 * half,
+                             half, io);
+    }
+    loser_tree<T, Compare> tree(sources, comp);
+    while (const T *head = sources[tree.winner()].head()) {
+        output.push(*head);
+        sources[tree.winner()].advance();
+        tree.replay();
+    }
+}
+
+inline void write_sorted_header(int fd,
+                                std::size_t element_size,
+                                std::size_t count,
+                                std::uint64_t payload_checksum) {
+    serialized_header header = make_header(serialized_header::raw_payload,
+                                           element_size, count);
+    header.payload_bytes = count * element_size;
+    header.checksum = payload_checksum;
+    pwrite_all(fd, &header, sizeof(header), 0);
+    if (ftruncate(fd, static_cast<off_t>(sizeof(header) +
+                                         count * element_size)) != 0) {
+        throw_errno("ftruncate");
+    }
+}
+}  // namespace detail
+
+// Sorts the vector serialized by serialize() in the file `input_fd` into
+// the file `output_fd`, using about `memory_budget` bytes of buffers.
+// Sorted runs are written to temporary files in `temp_directory` and
+// merged, in several passes if they are too many to merge with reasonably
+// large blocks. One background thread does the file I/O: reading the next
+// run overlaps sorting the current one, each merged run reads ahead into
+// a second block, and merged output is written while the next block
+// fills. Sorting a run merges through a scratch buffer of half a run, also
+// part of the budget. Both files are accessed from their beginning; the
+// comparator must be safe to call concurrently.
+template <typename T, typename Compare = std::less<T>>
+external_sort_stats external_sort(int input_fd,
+                                  int output_fd,
+                                  std::size_t memory_budget,
+                                  Compare comp = Compare(),
+                                  const std::string &temp_directory = "/tmp") {
+    static_assert(std::is_trivially_copyable_v<T>);
+    constexpr std::size_t min_merge_block_bytes = 64 * 1024;
+    // Two runs, one being read while the other is sorted, and the scratch
+    // buffer of the sort: five halves of a run.
+    std::size_t run_size = memory_budget * 2 / (5 * sizeof(T));
+    if (run_size == 0) {
+        throw std::invalid_argument("external_sort budget is too small");
+    }
+
+    serialized_header header;
+    detail::pread_all(input_fd, &header, sizeof(header), 0);
+    detail::validate_header(header, serialized_header::raw_payload, sizeof(T));
+    auto count = static_cast<std::size_t>(header.count);
+    external_sort_stats stats;
+    detail::io_thread io;
+
+    // Run generation: two buffers, one being read while the other is sorted.
+    std::vector<detail::sorted_run> runs;
+    detail::unique_fd runs_file(-1);
+    {
+        std::size_t buffer_size = std::min(run_size, count);
+        detail::raw_buffer<T> buffers(2 * buffer_size + buffer_size / 2 + 1);
+        T *current = buffers.get();
+        T *next = buffers.get() + buffer_size;
+        T *scratch = buffers.get() + 2 * buffer_size;
+        detail::checksum input_checksum;
+        auto read_run = [&](T *data, std::size_t begin) {
+            std::size_t size = std::min(run_size, count - begin);
+            return io.submit([=] {
+                detail::pread_all(
+                    input_fd, data, size * sizeof(T),
+                    sizeof(serialized_header) + begin * sizeof(T));
+            });
+        };
+        std::future<void> reading;
+        if (count > 0) {
+            reading = read_run(current, 0);
+        }
+        // The read in flight writes into `buffers`, freed on the way out.
+        try {
+            for (std::size_t begin = 0; begin < count; begin += run_size) {
+                std::size_t size = std::min(run_size, count - begin);
+                reading.get();
+                input_checksum.update(current, size * sizeof(T));
+                if (begin + size < count) {
+                    reading = read_run(next, begin + size);
+                }
+                detail::parallel_sort(current, size, scratch, comp);
+                if (size == count) {
+                    break;
+                }
+                if (runs_file.get() < 0) {
+                    runs_file = detail::unique_fd(
+                        detail::open_temporary_file(temp_directory));
+                }
+                detail::pwrite_all(runs_file.get(), current, size * sizeof(T),
+                                   begin * sizeof(T));
+                runs.push_back(detail::sorted_run{begin * sizeof(T), size});
+                std::swap(current, next);
+            }
+        } catch (...) {
+            if (reading.valid()) {
+                reading.wait();
+            }
+            throw;
+        }
+        if (input_checksum.value() != header.checksum) {
+            throw serialization_error("serialized vector checksum mismatch");
+        }
+        if (runs.empty()) {
+            stats.runs = count > 0 ? 1 : 0;
+            detail::checksum output_checksum;
+            output_checksum.update(buffers.get(), count * sizeof(T));
+            detail::pwrite_all(output_fd, buffers.get(), count * sizeof(T),
+                               sizeof(serialized_header));
+            detail::write_sorted_header(output_fd, sizeof(T), count,
+                                        output_checksum.value());
+            return stats;
+        }
+    }
+    stats.runs = runs.size();
+
+    // Merging: every input run and both output buffers get a block.
+    std::size_t fan_in = std::clamp<std::size_t>(
+        memory_budget / min_merge_block_bytes, 4, runs.size() + 2) - 2;
+    std::size_t block_size =
+        std::max<std::size_t>(1, memory_budget / ((fan_in + 2) * sizeof(T)));
+    while (runs.size() > fan_in) {
+        detail::unique_fd merged_file(
+            detail::open_temporary_file(temp_directory));
+        std::vector<detail::sorted_run> merged_runs;
+        std::uint64_t offset = 0;
+        for (std::size_t first = 0; first < runs.size(); first += fan_in) {
+            std::size_t group = std::min(fan_in, runs.size() - first);
+            std::size_t merged_count = 0;
+            for (std::size_t run = first; run < first + group; run++) {
+                merged_count += runs[run].count;
+            }
+            detail::double_buffered_writer<T> writer(merged_file.get(), offset,
+                                                     block_size, io);
+            detail::merge_runs(runs_file.get(), runs.data() + first, group,
+                               block_size, writer, io, comp);
+            writer.finish();
+            merged_runs.push_back(detail::sorted_run{offset, merged_count});
+            offset += merged_count * sizeof(T);
+        }
+        runs = std::move(merged_runs);
+        runs_file = std::move(merged_file);
+        stats.merge_passes++;
+    }
+    detail::double_buffered_writer<T> writer(
+        output_fd, sizeof(serialized_header), block_size, io);
+    detail::merge_runs(runs_file.get(), runs.data(), runs.size(), block_size,
+                       writer, io, comp);
+    writer.finish();
+    detail::write_sorted_header(output_fd, sizeof(T), count,
+                                writer.payload_checksum());
+    stats.merge_passes++;
+    return stats;
+}
+
+}  // namespace lab_07
+
+#endif  // EXTERNAL_SORT_H_
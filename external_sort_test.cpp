@@ -0,0 +1,96 @@
+#include "external_sort.h"
+#include <cstdint>
+#include <functional>
+#include <random>
+#include "doctest.h"
+#include "mapped_view.h"
+#include "parallel.h"
+#include "serialize.h"
+#include "test_temporary_file.h"
+#include "vector.h"
+
+namespace {
+struct Record {
+    std::uint32_t key;
+    std::uint32_t sequence;
+};
+
+bool by_key(const Record &lhs, const Record &rhs) {
+    return lhs.key < rhs.key;
+}
+}  // namespace
+
+TEST_CASE("external_sort sorts files larger than its budget") {
+    TemporaryFile input;
+    TemporaryFile output;
+    lab_07::vector<Record> records;
+    std::mt19937 random(7);
+    for (std::uint32_t i = 0; i < 200'000; i++) {
+        records.push_back(
+            Record{static_cast<std::uint32_t>(random() % 1'000), i});
+    }
+    lab_07::serialize(input.fd(), records);
+
+    std::size_t budget = 0;
+    std::size_t passes = 0;
+    SUBCASE("single merge pass") {
+        budget = 1 << 20;
+        passes = 1;
+    }
+    SUBCASE("several merge passes") {
+        budget = 512 * 1024;
+        passes = 2;
+    }
+    SUBCASE("runs sorted on several threads") {
+        budget = 1 << 20;
+        passes = 1;
+        lab_07::enable_parallel_construction(0, 4);
+    }
+    lab_07::external_sort_stats stats = lab_07::external_sort<Record>(
+        input.fd(), output.fd(), budget, by_key);
+    lab_07::disable_parallel_construction();
+    std::size_t run_size = budget * 2 / (5 * sizeof(Record));
+    CHECK(stats.runs == (200'000 + run_size - 1) / run_size);
+    CHECK(stats.merge_passes == passes);
+
+    lab_07::mapped_view<Record> sorted(output.path());
+    REQUIRE(sorted.size() == records.size());
+    CHECK(sorted.verify_checksum());
+    std::uint64_t sequence_sum = sorted[0].sequence;
+    for (std::size_t i = 1; i < sorted.size(); i++) {
+        REQUIRE(sorted[i - 1].key <= sorted[i].key);
+        sequence_sum += sorted[i].sequence;
+    }
+    CHECK(sequence_sum == std::uint64_t{199'999} * 200'000 / 2);
+}
+
+TEST_CASE("external_sort sorts in memory when the input fits") {
+    TemporaryFile input;
+    TemporaryFile output;
+    lab_07::vector<std::int64_t> values;
+    for (std::int64_t i = 0; i < 1'000; i++) {
+        values.push_back(std::int64_t{(i * 7'919) % 1'000});
+    }
+    lab_07::serialize(input.fd(), values);
+    lab_07::external_sort_stats stats =
+        lab_07::external_sort<std::int64_t>(input.fd(), output.fd(), 1 << 20,
+                                            std::greater<>());
+    CHECK(stats.runs == 1);
+    CHECK(stats.merge_passes == 0);
+    auto sorted = lab_07::deserialize<std::int64_t>(output.fd());
+    REQUIRE(sorted.size() == 1'000);
+    CHECK(sorted[0] == 999);
+    CHECK(sorted[999] == 0);
+}
+
+TEST_CASE("external_sort rejects corrupted input") {
+    TemporaryFile input;
+    TemporaryFile output;
+    lab_07::serialize(input.fd(), lab_07::vector<std::int64_t>(10'000));
+    std::int64_t corrupted = 1;
+    REQUIRE(pwrite(input.fd(), &corrupted, sizeof(corrupted), 1'000) ==
+            sizeof(corrupted));
+    CHECK_THROWS_AS(lab_07::external_sort<std::int64_t>(input.fd(),
+                                                        output.fd(), 4096),
+                    lab_07::serialization_error);
+}
@@ -0,0 +1,172 @@
+#ifndef FD_IO_H_
+#define FD_IO_H_
+
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "serialize.h"
+#include "vector.h"
+
+namespace lab_07 {
+namespace detail {
+template <typename T>
+constexpr bool is_byte_like_v =
+    sizeof(T) == 1 && std::is_trivially_copyable_v<T> &&
+    std::is_trivially_destructible_v<T>;
+}  // namespace detail
+
+struct append_result {
+    std::size_t bytes = 0;
+    // The peer closed the stream; false when `max` bytes were appended or a
+    // non-blocking fd had no data yet.
+    bool end_of_file = false;
+};
+
+// Appends bytes read from `fd` to `buffer` until end of file, until `max`
+// bytes were appended or until a non-blocking `fd` has no more data, and
+// returns the number of bytes appended and whether it was end of file. Reads go straight into the spare
+// capacity; a stack buffer after it catches the rest of larger reads, so a
+// full tail costs one read instead of two. Capacity grows geometrically.
+template <typename T, typename Alloc, typename... Policies>
+append_result append_from_fd(
+    int fd,
+    vector<T, Alloc, Policies...> &buffer,
+    std::size_t max = std::numeric_limits<std::size_t>::max()) {
+    static_assert(detail::is_byte_like_v<T>);
+    constexpr std::size_t min_capacity = 4096;
+    char overflow[16 * 1024];
+    append_result result;
+    std::size_t &total = result.bytes;
+    while (total < max) {
+        if (buffer.size() == buffer.capacity()) {
+            buffer.reserve(std::max(buffer.capacity() * 2, min_capacity));
+        }
+        std::size_t old_size = buffer.size();
+        std::size_t spare =
+            std::min(buffer.capacity() - old_size, max - total);
+        ssize_t got = 0;
+        int error = 0;
+        auto read_into_tail = [&](T *data, std::size_t) {
+            iovec parts[2] = {
+                {data + old_size, spare},
+                {overflow, std::min(sizeof(overflow), max - total - spare)}};
+            got = readv(fd, parts, parts[1].iov_len > 0 ? 2 : 1);
+            error = errno;
+            return got > 0 ? old_size + std::min(spare,
+                                                 static_cast<std::size_t>(got))
+                           : old_size;
+        };
+        buffer.resize_and_overwrite(old_size + spare, read_into_tail);
+        if (got < 0) {
+            if (error == EINTR) {
+                continue;
+            }
+            if (error == EAGAIN || error == EWOULDBLOCK) {
+                break;
+            }
+            errno = error;
+            detail::throw_errno("readv");
+        }
+        if (got == 0) {
+            result.end_of_file = true;
+            break;
+        }
+        auto read_bytes = static_cast<std::size_t>(got);
+        if (read_bytes > spare) {
+            std::size_t extra = read_bytes - spare;
+            std::size_t size = buffer.size();
+            auto copy_overflow = [&](T *data, std::size_t count) {
+                std::memcpy(data + size, overflow, extra);
+                return count;
+            };
+            buffer.resize_and_overwrite(size + extra, copy_overflow);
+        }
+        total += read_bytes;
+    }
+    return result;
+}
+
+// Writes `buffer` from byte `offset` on to `fd` in as few write calls as the
+// kernel allows and returns the offset reached: the end of the buffer, or
+// less if a non-blocking `fd` stopped accepting data.
+template <typename T, typename Alloc, typename... Policies>
+std::size_t write_to_fd(int fd,
+                        const vector<T, Alloc, Policies...> &buffer,
+                        std::size_t offset = 0) {
+    static_assert(detail::is_byte_like_v<T>);
+    while (offset < buffer.size()) {
+        ssize_t written =
+            ::write(fd, buffer.data() + offset, buffer.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            detail::throw_errno("write");
+        }
+        offset += static_cast<std::size_t>(written);
+    }
+    return offset;
+}
+
+// Gathers `count` buffers into writev calls, writing all of them unless a
+// non-blocking `fd` stops accepting data. Returns the number of bytes
+// written.
+template <typename T, typename Alloc, typename... Policies>
+std::size_t write_to_fd(int fd,
+                        const vector<T, Alloc, Policies...> *buffers,
+                        std::size_t count) {
+    static_assert(detail::is_byte_like_v<T>);
+    constexpr std::size_t max_parts = 64;
+    std::size_t total = 0;
+    std::size_t first = 0;
+    std::size_t first_offset = 0;
+    while (first < count) {
+        iovec parts[max_parts];
+        std::size_t used = 0;
+        for (std::size_t index = first; index < count && used < max_parts;
+             index++) {
+            std::size_t skip = index == first ? first_offset : 0;
+            if (buffers[index].size() > skip) {
+                parts[used++] = {
+                    const_cast<T *>(buffers[index].data()) + skip,
+                    buffers[index].size() - skip};
+            }
+        }
+        if (used == 0) {
+            break;
+        }
+        ssize_t written = writev(fd, parts, static_cast<int>(used));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            detail::throw_errno("writev");
+        }
+        total += static_cast<std::size_t>(written);
+        // Skips the buffers that were written completely.
+        auto remaining = static_cast<std::size_t>(written);
+        while (first < count &&
+               remaining >= buffers[first].size() - first_offset) {
+            remaining -= buffers[first].size() - first_offset;
+            first++;
+            first_offset = 0;
+        }
+        first_offset += remaining;
+    }
+    return total;
+}
+
+}  // namespace lab_07
+
+#endif  // FD_IO_H_
@@ -0,0 +1,115 @@
+#include "fd_io.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstddef>
+#include <thread>
+#include "doctest.h"
+#include "test_temporary_file.h"
+#include "vector.h"
+
+namespace {
+class Pipe {
+    int fds_[2] = {-1, -1};
+
+public:
+    Pipe() {
+        REQUIRE(pipe(fds_) == 0);
+    }
+    Pipe(const Pipe &) = delete;
+    Pipe &operator=(const Pipe &) = delete;
+    ~Pipe() {
+        close_write();
+        close(fds_[0]);
+    }
+
+    [[nodiscard]] int read_end() const {
+        return fds_[0];
+    }
+
+    [[nodiscard]] int write_end() const {
+        return fds_[1];
+    }
+
+    void close_write() {
+        if (fds_[1] >= 0) {
+            close(fds_[1]);
+            fds_[1] = -1;
+        }
+    }
+};
+}  // namespace
+
+TEST_CASE("append_from_fd reads a stream into spare capacity") {
+    Pipe channel;
+    lab_07::vector<char> payload;
+    for (int i = 0; i < 1'000'000; i++) {
+        payload.push_back(static_cast<char>('a' + i % 26));
+    }
+    std::thread writer([&] {
+        CHECK(lab_07::write_to_fd(channel.write_end(), payload) ==
+              payload.size());
+        channel.close_write();
+    });
+
+    lab_07::vector<char> received;
+    received.push_back('>');
+    lab_07::append_result first =
+        lab_07::append_from_fd(channel.read_end(), received, 100'000);
+    CHECK(first.bytes == 100'000);
+    CHECK_FALSE(first.end_of_file);
+    lab_07::append_result rest =
+        lab_07::append_from_fd(channel.read_end(), received);
+    writer.join();
+    CHECK(rest.bytes == 900'000);
+    CHECK(rest.end_of_file);
+    REQUIRE(received.size() == 1'000'001);
+    CHECK(received[0] == '>');
+    for (std::size_t i = 0; i < payload.size(); i += 4'099) {
+        REQUIRE(received[i + 1] == payload[i]);
+    }
+    lab_07::append_result closed =
+        lab_07::append_from_fd(channel.read_end(), received);
+    CHECK(closed.bytes == 0);
+    CHECK(closed.end_of_file);
+}
+
+TEST_CASE("append_from_fd stops when a non-blocking fd has no data") {
+    Pipe channel;
+    REQUIRE(fcntl(channel.read_end(), F_SETFL, O_NONBLOCK) == 0);
+    lab_07::vector<std::byte> received;
+    lab_07::append_result empty =
+        lab_07::append_from_fd(channel.read_end(), received);
+    CHECK(empty.bytes == 0);
+    CHECK_FALSE(empty.end_of_file);
+
+    REQUIRE(write(channel.write_end(), "abc", 3) == 3);
+    lab_07::append_result some =
+        lab_07::append_from_fd(channel.read_end(), received);
+    CHECK(some.bytes == 3);
+    CHECK_FALSE(some.end_of_file);
+    CHECK(received[2] == std::byte{'c'});
+
+    REQUIRE(write(channel.write_end(), "de", 2) == 2);
+    channel.close_write();
+    lab_07::append_result last =
+        lab_07::append_from_fd(channel.read_end(), received);
+    CHECK(last.bytes == 2);
+    CHECK(last.end_of_file);
+    CHECK(received.size() == 5);
+}
+
+TEST_CASE("write_to_fd gathers several buffers") {
+    TemporaryFile file;
+    lab_07::vector<char> parts[3];
+    parts[0].push_back('x');
+    parts[2].resize(70'000, 'z');
+    CHECK(lab_07::write_to_fd(file.fd(), parts, 3) == 70'001);
+    CHECK(lab_07::write_to_fd(file.fd(), parts[0]) == 1);
+
+    file.rewind();
+    lab_07::vector<char> contents;
+    CHECK(lab_07::append_from_fd(file.fd(), contents).bytes == 70'002);
+    CHECK(contents[0] == 'x');
+    CHECK(contents[70'000] == 'z');
+    CHECK(contents[70'001] == 'x');
+}
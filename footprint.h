@@ -0,0 +1,131 @@
+#ifndef FOOTPRINT_H_
+#define FOOTPRINT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "exceptions.h"
+#include "parallel.h"
+#include "vector.h"
+
+namespace lab_07 {
+// Heap memory in bytes owned by an object, not counting sizeof(T) itself.
+// Specialize with a `static std::size_t of(const T &) noexcept` for types
+// owning memory; the default counts nothing.
+template <typename T, typename = void>
+struct owned_memory {
+    static constexpr bool owns_nothing = true;
+
+    static std::size_t of(const T &) noexcept {
+        return 0;
+    }
+};
+
+// The heap buffer, unless the characters are stored in the object (SSO).
+template <typename Char, typename Traits, typename Alloc>
+struct owned_memory<std::basic_string<Char, Traits, Alloc>> {
+    static std::size_t of(
+        const std::basic_string<Char, Traits, Alloc> &string) noexcept {
+        const auto *object = reinterpret_cast<const unsigned char *>(&string);
+        const auto *characters =
+            reinterpret_cast<const unsigned char *>(string.data());
+        std::less<const unsigned char *> less;
+        if (!less(characters, object) &&
+            less(characters, object + sizeof(string))) {
+            return 0;
+        }
+        return (string.capacity() + 1) * sizeof(Char);
+    }
+};
+
+// The pointee as its static type, so a derived object is undercounted.
+template <typename T, typename Deleter>
+struct owned_memory<std::unique_ptr<T, Deleter>,
+                    std::enable_if_t<!std::is_array_v<T>>> {
+    static std::size_t of(const std::unique_ptr<T, Deleter> &pointer) noexcept {
+        if (pointer == nullptr) {
+            return 0;
+        }
+        return sizeof(T) + owned_memory<T>::of(*pointer);
+    }
+};
+
+template <typename T, typename Alloc, typename... Policies>
+std::size_t memory_footprint(const vector<T, Alloc, Policies...> &v);
+
+template <typename T, typename Alloc, typename... Policies>
+struct owned_memory<vector<T, Alloc, Policies...>> {
+    static std::size_t of(const vector<T, Alloc, Policies...> &v) {
+        return memory_footprint(v);
+    }
+};
+
+namespace detail {
+template <typename T, typename = void>
+struct owns_nothing : std::false_type {};
+
+template <typename T>
+struct owns_nothing<T, std::enable_if_t<owned_memory<T>::owns_nothing>>
+    : std::true_type {};
+
+template <typename T>
+std::size_t owned_memory_of_range(const T *begin, const T *end) {
+    std::size_t total = 0;
+    for (; begin != end; ++begin) {
+        total += owned_memory<T>::of(*begin);
+    }
+    return total;
+}
+}  // namespace detail
+
+// Bytes of the buffer of `v` (its capacity, not its size) plus the memory
+// owned by the elements, without sizeof(v) itself. Elements are visited
+// concurrently under the thresholds of enable_parallel_construction();
+// owned_memory<T>::of must then be safe to call concurrently; exceptions it
+// throws, such as bad_alloc from nested vectors, reach the caller.
+template <typename T, typename Alloc, typename... Policies>
+std::size_t memory_footprint(const vector<T, Alloc, Policies...> &v) {
+    std::size_t total = v.capacity() * sizeof(T);
+    if constexpr (!detail::owns_nothing<T>::value) {
+        const T *data = v.data();
+        std::size_t chunks = detail::parallel_chunks(v.size(), sizeof(T));
+        if (chunks == 1) {
+            return total + detail::owned_memory_of_range(data, data + v.size());
+        }
+        // Pool tasks must not throw, so errors wait for the calling thread.
+        std::vector<std::size_t> chunk_totals(chunks);
+        std::vector<std::exception_ptr> errors(chunks);
+        detail::thread_pool::instance().run(
+            chunks, detail::parallel_thread_count(), [&](std::size_t chunk) {
+                auto [begin, end] =
+                    detail::chunk_bounds(0, v.size(), chunk, chunks);
+                LAB_07_TRY {
+                    chunk_totals[chunk] = detail::owned_memory_of_range(
+                        data + begin, data + end);
+                }
+                LAB_07_CATCH(...) {
+                    errors[chunk] = std::current_exception();
+                }
+            });
+        auto error = std::find_if(errors.begin(), errors.end(),
+                                  [](const std::exception_ptr &chunk_error) {
+                                      return chunk_error != nullptr;
+                                  });
+        if (error != errors.end()) {
+            std::rethrow_exception(*error);
+        }
+        for (std::size_t chunk_total : chunk_totals) {
+            total += chunk_total;
+        }
+    }
+    return total;
+}
+
+}  // namespace lab_07
+
+#endif  // FOOTPRINT_H_
@@ -0,0 +1,86 @@
+#include "footprint.h"
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "doctest.h"
+#include "parallel.h"
+#include "vector.h"
+
+namespace {
+struct blob {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::size_t bytes = 0;
+};
+
+struct faulty {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    bool fails = false;
+};
+}  // namespace
+
+namespace lab_07 {
+template <>
+struct owned_memory<blob> {
+    static std::size_t of(const blob &value) noexcept {
+        return value.bytes;
+    }
+};
+
+template <>
+struct owned_memory<faulty> {
+    static std::size_t of(const faulty &value) {
+        if (value.fails) {
+            throw std::runtime_error("failed");
+        }
+        return 0;
+    }
+};
+}  // namespace lab_07
+
+TEST_CASE("memory_footprint counts the buffer of trivial elements") {
+    lab_07::vector<int> v(5);
+    CHECK(lab_07::memory_footprint(v) == 8 * sizeof(int));
+    CHECK(lab_07::memory_footprint(lab_07::vector<int>()) == 0);
+}
+
+TEST_CASE("memory_footprint counts memory owned by elements") {
+    lab_07::vector<std::string> strings;
+    strings.push_back(std::string("short"));
+    std::string long_string(1'000, 'x');
+    strings.push_back(long_string);
+    CHECK(lab_07::memory_footprint(strings) ==
+          2 * sizeof(std::string) + (long_string.capacity() + 1));
+
+    lab_07::vector<lab_07::vector<int>> nested(2);
+    nested[1].resize(3);
+    CHECK(lab_07::memory_footprint(nested) ==
+          2 * sizeof(lab_07::vector<int>) + 4 * sizeof(int));
+
+    lab_07::vector<std::unique_ptr<blob>> pointers(4);
+    pointers[0] = std::make_unique<blob>(blob{100});
+    CHECK(lab_07::memory_footprint(pointers) ==
+          4 * sizeof(std::unique_ptr<blob>) + sizeof(blob) + 100);
+}
+
+TEST_CASE("memory_footprint sums huge vectors in parallel") {
+    lab_07::vector<blob> blobs(10'000);
+    for (std::size_t index = 0; index < blobs.size(); index++) {
+        blobs[index].bytes = index;
+    }
+    std::size_t expected =
+        16'384 * sizeof(blob) + blobs.size() * (blobs.size() - 1) / 2;
+    CHECK(lab_07::memory_footprint(blobs) == expected);
+    lab_07::enable_parallel_construction(0, 4);
+    CHECK(lab_07::memory_footprint(blobs) == expected);
+    lab_07::disable_parallel_construction();
+}
+
+TEST_CASE("memory_footprint passes errors of parallel chunks to the caller") {
+    lab_07::vector<faulty> values(1'000);
+    values[999].fails = true;
+    lab_07::enable_parallel_construction(0, 4);
+    CHECK_THROWS_AS(static_cast<void>(lab_07::memory_footprint(values)),
+                    std::runtime_error);
+    lab_07::disable_parallel_construction();
+}
@@ -0,0 +1,337 @@
+// Measures what the strong exception guarantee of lab_07::vector costs, by
+// timing the same operations on a vector that only gives the basic
+// guarantee, on lab_07::vector with exception_policy::basic and on
+// std::vector, and prints the results as JSON:
+//
+//     guarantee-bench [--size N] [--repetitions R] > results.json
+//
+// Happy-path results report the median time per element. Fault results
+// make the element copy throw at a given percentage of the way through the
+// operation and report the median time of the failed operation, including
+// the rollback and the catch.
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "vector.h"
+
+namespace {
+struct artificial_exception {};
+
+// Number of copies of `faulty` left before one throws; negative disables
+// fault injection. Vectors construct on the calling thread unless parallel
+// construction is enabled, which this benchmark does not do.
+long copies_until_fault = -1;
+
+struct faulty {
+    int value = 0;
+
+    faulty() = default;
+
+    explicit faulty(int value_) noexcept : value(value_) {
+    }
+
+    faulty(const faulty &other) : value(other.value) {
+        if (copies_until_fault >= 0 && copies_until_fault-- == 0) {
+            throw artificial_exception();
+        }
+    }
+
+    faulty(faulty &&) noexcept = default;
+    faulty &operator=(const faulty &) = default;
+    faulty &operator=(faulty &&) noexcept = default;
+    ~faulty() = default;
+};
+
+// Same layout and growth policy as lab_07::vector, but an operation that
+// throws keeps the elements constructed so far instead of rolling back, so
+// nothing needs a try/catch.
+template <typename T>
+class basic_vector {
+    T *data_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::size_t size_ = 0;
+
+    void grow(std::size_t new_capacity) {
+        T *extradata = std::allocator<T>().allocate(new_capacity);
+        for (std::size_t index = 0; index < size_; index++) {
+            new (extradata + index) T(std::move(data_[index]));
+            data_[index].~T();
+        }
+        if (data_ != nullptr) {
+            std::allocator<T>().deallocate(data_, capacity_);
+        }
+        data_ = extradata;
+        capacity_ = new_capacity;
+    }
+
+public:
+    basic_vector() noexcept = default;
+
+    // Delegates to the default constructor, so the destructor cleans up if
+    // an element copy throws.
+    basic_vector(const basic_vector &other) : basic_vector() {
+        reserve(other.size_);
+        for (; size_ < other.size_; size_++) {
+            new (data_ + size_) T(other.data_[size_]);
+        }
+    }
+
+    basic_vector &operator=(const basic_vector &) = delete;
+
+    ~basic_vector() noexcept {
+        for (std::size_t index = 0; index < size_; index++) {
+            data_[index].~T();
+        }
+        if (data_ != nullptr) {
+            std::allocator<T>().deallocate(data_, capacity_);
+        }
+    }
+
+    void reserve(std::size_t quantity) {
+        quantity = lab_07::calculate_capacity(quantity);
+        if (quantity > capacity_) {
+            grow(quantity);
+        }
+    }
+
+    void resize(std::size_t desired_size, const T &element) {
+        reserve(desired_size);
+        for (; size_ < desired_size; size_++) {
+            new (data_ + size_) T(element);
+        }
+        for (; size_ > desired_size; size_--) {
+            data_[size_ - 1].~T();
+        }
+    }
+
+    void push_back(const T &element) {
+        if (size_ == capacity_) {
+            grow(capacity_ == 0 ? 1 : capacity_ * 2);
+        }
+        new (data_ + size_) T(element);
+        size_++;
+    }
+
+    [[nodiscard]] const T &operator[](std::size_t index) const noexcept {
+        return data_[index];
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return size_;
+    }
+};
+
+template <typename T>
+using basic_policy_vector =
+    lab_07::vector<T, std::allocator<T>, lab_07::exception_policy::basic>;
+
+template <typename T>
+T make_value(std::size_t index);
+
+template <>
+int make_value<int>(std::size_t index) {
+    return static_cast<int>(index);
+}
+
+template <>
+std::string make_value<std::string>(std::size_t index) {
+    // Longer than the small string buffer, so every copy allocates.
+    return "benchmark string number " + std::to_string(index);
+}
+
+template <>
+faulty make_value<faulty>(std::size_t index) {
+    return faulty(static_cast<int>(index));
+}
+
+template <typename T>
+const char *type_name();
+
+template <>
+const char *type_name<int>() {
+    return "int";
+}
+
+template <>
+const char *type_name<std::string>() {
+    return "std::string";
+}
+
+template <>
+const char *type_name<faulty>() {
+    return "faulty";
+}
+
+volatile std::size_t sink;
+
+struct Options {
+    std::size_t size = 10'000;
+    std::size_t repetitions = 11;
+};
+
+class Reporter {
+    bool first_ = true;
+
+public:
+    Reporter() {
+        std::printf("{\n  \"benchmarks\": [");
+    }
+    Reporter(const Reporter &) = delete;
+    Reporter &operator=(const Reporter &) = delete;
+    ~Reporter() {
+        std::printf("\n  ]\n}\n");
+    }
+
+    // `fault_percent` is negative for happy-path results.
+    void report(const char *container,
+                const char *type,
+                const char *scenario,
+                std::size_t size,
+                int fault_percent,
+                double ns_per_run) {
+        std::printf(
+            "%s\n    {\"container\": \"%s\", \"type\": \"%s\", "
+            "\"scenario\": \"%s\", \"size\": %zu, ",
+            first_ ? "" : ",", container, type, scenario, size);
+        if (fault_percent < 0) {
+            std::printf("\"ns_per_op\": %.3f}",
+                        ns_per_run / static_cast<double>(size));
+        } else {
+            std::printf(
+                "\"fault_at_percent\": %d, \"ns_per_failed_run\": %.1f}",
+                fault_percent, ns_per_run);
+        }
+        first_ = false;
+    }
+};
+
+// Runs `setup` then times `body` `repetitions` times and returns the median
+// time of one run in nanoseconds. If `fault_after` is not negative, the
+// copy after `fault_after` copies of `faulty` throws during `body`.
+template <typename Setup, typename Body>
+double measure(const Options &options,
+               long fault_after,
+               Setup setup,
+               Body body) {
+    std::vector<double> timings;
+    for (std::size_t repetition = 0; repetition < options.repetitions;
+         repetition++) {
+        auto state = setup();
+        copies_until_fault = fault_after;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            body(state);
+        } catch (const artificial_exception &) {
+            sink = 0;
+        }
+        auto finish = std::chrono::steady_clock::now();
+        copies_until_fault = -1;
+        timings.push_back(
+            std::chrono::duration<double, std::nano>(finish - start).count());
+    }
+    std::nth_element(timings.begin(), timings.begin() + timings.size() / 2,
+                     timings.end());
+    return timings[timings.size() / 2];
+}
+
+// Times every scenario once without faults, and for `faulty` also with a
+// copy throwing 0, 25, 50, 75 and 99 percent of the way through.
+template <template <typename...> class Vector, typename T>
+void run_scenarios(Reporter &reporter,
+                   const char *container,
+                   const Options &options) {
+    const char *type = type_name<T>();
+    std::size_t size = options.size;
+    T element = make_value<T>(size);
+    auto filled = [&] {
+        Vector<T> vec;
+        for (std::size_t index = 0; index < size; index++) {
+            vec.push_back(make_value<T>(index));
+        }
+        return vec;
+    };
+    auto empty = [] { return Vector<T>(); };
+    auto reserved = [size] {
+        Vector<T> vec;
+        vec.reserve(size);
+        return vec;
+    };
+
+    auto copy = [](Vector<T> &vec) {
+        Vector<T> result(vec);
+        sink = result.size();
+    };
+    auto resize_grow = [&](Vector<T> &vec) {
+        vec.resize(size, element);
+        sink = vec.size();
+    };
+    auto push_back_copy = [&](Vector<T> &vec) {
+        for (std::size_t index = 0; index < size; index++) {
+            vec.push_back(element);
+        }
+        sink = vec.size();
+    };
+
+    auto report_all = [&](const char *scenario, auto setup, auto body) {
+        reporter.report(container, type, scenario, size, -1,
+                        measure(options, -1, setup, body));
+        if constexpr (std::is_same_v<T, faulty>) {
+            for (int percent : {0, 25, 50, 75, 99}) {
+                long fault_after = static_cast<long>(
+                    size * static_cast<std::size_t>(percent) / 100);
+                reporter.report(container, type, scenario, size, percent,
+                                measure(options, fault_after, setup, body));
+            }
+        }
+    };
+
+    report_all("copy", filled, copy);
+    report_all("resize_grow", empty, resize_grow);
+    report_all("resize_in_capacity", reserved, resize_grow);
+    report_all("push_back_copy", empty, push_back_copy);
+}
+
+template <template <typename...> class Vector>
+void run_container(Reporter &reporter,
+                   const char *container,
+                   const Options &options) {
+    run_scenarios<Vector, int>(reporter, container, options);
+    run_scenarios<Vector, std::string>(reporter, container, options);
+    run_scenarios<Vector, faulty>(reporter, container, options);
+}
+
+Options parse_options(int argc, char **argv) {
+    Options options;
+    for (int index = 1; index + 1 < argc; index += 2) {
+        std::size_t value = std::strtoull(argv[index + 1], nullptr, 10);
+        if (std::strcmp(argv[index], "--size") == 0) {
+            options.size = std::max<std::size_t>(1, value);
+        } else if (std::strcmp(argv[index], "--repetitions") == 0) {
+            options.repetitions = std::max<std::size_t>(1, value);
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s [--size N] [--repetitions R]\n",
+                         argv[0]);
+            std::exit(2);
+        }
+    }
+    return options;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options = parse_options(argc, argv);
+    Reporter reporter;
+    run_container<lab_07::vector>(reporter, "lab_07::vector", options);
+    run_container<basic_policy_vector>(reporter, "lab_07::vector<basic>",
+                                       options);
+    run_container<basic_vector>(reporter, "basic_vector", options);
+    run_container<std::vector>(reporter, "std::vector", options);
+}
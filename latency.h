@@ -0,0 +1,382 @@
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include "exceptions.h"
+#include "stats.h"
+
+namespace lab_07 {
+// Log-linear histogram of durations in nanoseconds, in the style of HDR
+// histograms: every power of two is split into 8 buckets, so a recorded
+// value is known within 12.5%. Durations from 2^40 ns (18 minutes) on share
+// the last bucket.
+class latency_histogram {
+public:
+    static constexpr unsigned sub_bucket_bits = 3;
+    static constexpr std::size_t sub_buckets = std::size_t{1}
+                                               << sub_bucket_bits;
+    static constexpr unsigned max_exponent = 40;
+    static constexpr std::size_t bucket_count =
+        (max_exponent - sub_bucket_bits + 1) * sub_buckets;
+
+    [[nodiscard]] static std::size_t bucket_of(std::uint64_t nanoseconds) {
+        if (nanoseconds < sub_buckets) {
+            return static_cast<std::size_t>(nanoseconds);
+        }
+        unsigned exponent = 63 - static_cast<unsigned>(
+                                     __builtin_clzll(nanoseconds));
+        if (exponent >= max_exponent) {
+            return bucket_count - 1;
+        }
+        unsigned shift = exponent - sub_bucket_bits;
+        auto sub_bucket =
+            static_cast<std::size_t>(nanoseconds >> shift) & (sub_buckets - 1);
+        return (shift + 1) * sub_buckets + sub_bucket;
+    }
+
+    // Smallest duration falling into `bucket`.
+    [[nodiscard]] static std::uint64_t lower_bound(std::size_t bucket) {
+        if (bucket < sub_buckets) {
+            return bucket;
+        }
+        std::size_t shift = bucket / sub_buckets - 1;
+        return (sub_buckets + bucket % sub_buckets) << shift;
+    }
+
+    // Largest duration falling into `bucket`.
+    [[nodiscard]] static std::uint64_t upper_bound(std::size_t bucket) {
+        if (bucket < sub_buckets) {
+            return bucket;
+        }
+        return lower_bound(bucket) +
+               (std::uint64_t{1} << (bucket / sub_buckets - 1)) - 1;
+    }
+
+    std::array<std::uint64_t, bucket_count> counts{};
+
+    void record(std::uint64_t nanoseconds) noexcept {
+        counts[bucket_of(nanoseconds)]++;
+    }
+
+    void merge(const latency_histogram &other) noexcept {
+        for (std::size_t bucket = 0; bucket < bucket_count; bucket++) {
+            counts[bucket] += other.counts[bucket];
+        }
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept {
+        std::uint64_t total = 0;
+        for (std::uint64_t bucket_total : counts) {
+            total += bucket_total;
+        }
+        return total;
+    }
+
+    // Upper bound of the bucket holding the `percentile`th duration, or 0
+    // if nothing was recorded.
+    [[nodiscard]] std::uint64_t value_at_percentile(double percentile) const {
+        std::uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        auto rank = static_cast<std::uint64_t>(
+            percentile / 100 * static_cast<double>(total - 1));
+        std::uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket < bucket_count; bucket++) {
+            seen += counts[bucket];
+            if (seen > rank) {
+                return upper_bound(bucket);
+            }
+        }
+        return upper_bound(bucket_count - 1);
+    }
+};
+
+// Durations of one phase of vector growth for one element type and one
+// range of new capacities, [capacity_bytes_min, 2 * capacity_bytes_min).
+struct growth_latency {
+    std::string type;
+    growth_phase phase = growth_phase::allocate;
+    std::size_t capacity_bytes_min = 0;
+    latency_histogram histogram;
+};
+
+namespace detail {
+// Histograms written by one thread. Each counter has a single writer, so
+// recording is a relaxed load and store; readers may run concurrently and
+// see slightly stale counts.
+class growth_histograms {
+public:
+    static constexpr std::size_t max_types = 256;
+    static constexpr std::size_t phases = 3;
+    static constexpr std::size_t capacity_buckets = 64;
+
+private:
+    struct histogram_cells {
+        std::array<std::atomic<std::uint64_t>, latency_histogram::bucket_count>
+            counts{};
+    };
+
+    struct type_cells {
+        std::array<std::atomic<histogram_cells *>, phases * capacity_buckets>
+            histograms{};
+
+        ~type_cells() {
+            for (auto &histogram : histograms) {
+                delete histogram.load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::array<std::atomic<type_cells *>, max_types> types_{};
+
+public:
+    growth_histograms() = default;
+    growth_histograms(const growth_histograms &) = delete;
+    growth_histograms &operator=(const growth_histograms &) = delete;
+
+    ~growth_histograms() {
+        for (auto &type : types_) {
+            delete type.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Called by the owning thread only. Cells are allocated on first use.
+    void record(std::size_t type_id,
+                std::size_t slot,
+                std::uint64_t nanoseconds) {
+        type_cells *type = types_[type_id].load(std::memory_order_relaxed);
+        if (type == nullptr) {
+            type = new type_cells;
+            types_[type_id].store(type, std::memory_order_release);
+        }
+        histogram_cells *histogram =
+            type->histograms[slot].load(std::memory_order_relaxed);
+        if (histogram == nullptr) {
+            histogram = new histogram_cells;
+            type->histograms[slot].store(histogram, std::memory_order_release);
+        }
+        std::atomic<std::uint64_t> &count =
+            histogram->counts[latency_histogram::bucket_of(nanoseconds)];
+        count.store(count.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    }
+
+    // Calls `visit(type_id, slot, histogram)` for every histogram in use.
+    template <typename Visit>
+    void for_each(const Visit &visit) const {
+        for (std::size_t type_id = 0; type_id < max_types; type_id++) {
+            type_cells *type = types_[type_id].load(std::memory_order_acquire);
+            if (type == nullptr) {
+                continue;
+            }
+            for (std::size_t slot = 0; slot < phases * capacity_buckets;
+                 slot++) {
+                histogram_cells *cells =
+                    type->histograms[slot].load(std::memory_order_acquire);
+                if (cells == nullptr) {
+                    continue;
+                }
+                latency_histogram histogram;
+                for (std::size_t bucket = 0;
+                     bucket < latency_histogram::bucket_count; bucket++) {
+                    histogram.counts[bucket] =
+                        cells->counts[bucket].load(std::memory_order_relaxed);
+                }
+                visit(type_id, slot, histogram);
+            }
+        }
+    }
+};
+
+// Every thread's histograms, plus the merged histograms of threads that
+// exited. Only registration, thread exit and reports take the mutex.
+class growth_registry {
+    std::mutex mutex_;
+    std::vector<std::string> type_names_;
+    std::vector<const growth_histograms *> threads_;
+    std::vector<growth_latency> retired_;
+
+    static void add(std::vector<growth_latency> &entries,
+                    const std::string &type,
+                    std::size_t slot,
+                    const latency_histogram &histogram) {
+        auto phase = static_cast<growth_phase>(
+            slot / growth_histograms::capacity_buckets);
+        std::size_t capacity_bytes_min =
+            std::size_t{1} << (slot % growth_histograms::capacity_buckets);
+        for (growth_latency &entry : entries) {
+            if (entry.type == type && entry.phase == phase &&
+                entry.capacity_bytes_min == capacity_bytes_min) {
+                entry.histogram.merge(histogram);
+                return;
+            }
+        }
+        entries.push_back({type, phase, capacity_bytes_min, histogram});
+    }
+
+    void collect(std::vector<growth_latency> &entries,
+                 const growth_histograms &histograms) {
+        histograms.for_each([&](std::size_t type_id, std::size_t slot,
+                                const latency_histogram &histogram) {
+            add(entries, type_names_[type_id], slot, histogram);
+        });
+    }
+
+public:
+    static growth_registry &instance() {
+        static growth_registry registry;
+        return registry;
+    }
+
+    // Returns the id of `name`, or max_types once that many types exist.
+    std::size_t type_id(const char *name) {
+        std::lock_guard lock(mutex_);
+        if (type_names_.size() == growth_histograms::max_types) {
+            return growth_histograms::max_types;
+        }
+        type_names_.emplace_back(name);
+        return type_names_.size() - 1;
+    }
+
+    void attach(const growth_histograms *histograms) {
+        std::lock_guard lock(mutex_);
+        threads_.push_back(histograms);
+    }
+
+    void detach(const growth_histograms *histograms) {
+        std::lock_guard lock(mutex_);
+        collect(retired_, *histograms);
+        threads_.erase(
+            std::find(threads_.begin(), threads_.end(), histograms));
+    }
+
+    std::vector<growth_latency> report() {
+        std::lock_guard lock(mutex_);
+        std::vector<growth_latency> entries = retired_;
+        for (const growth_histograms *histograms : threads_) {
+            collect(entries, *histograms);
+        }
+        return entries;
+    }
+};
+
+// The calling thread's histograms, registered while the thread runs.
+class thread_growth_histograms : public growth_histograms {
+public:
+    thread_growth_histograms() {
+        growth_registry::instance().attach(this);
+    }
+
+    thread_growth_histograms(const thread_growth_histograms &) = delete;
+    thread_growth_histograms &operator=(const thread_growth_histograms &) =
+        delete;
+
+    ~thread_growth_histograms() {
+        growth_registry::instance().detach(this);
+    }
+
+    static thread_growth_histograms &current() {
+        thread_local thread_growth_histograms histograms;
+        return histograms;
+    }
+};
+
+template <typename T>
+std::size_t growth_type_id() {
+    static const std::size_t id =
+        growth_registry::instance().type_id(typeid(T).name());
+    return id;
+}
+
+inline const char *phase_name(growth_phase phase) noexcept {
+    switch (phase) {
+        case growth_phase::allocate:
+            return "allocate";
+        case growth_phase::relocate:
+            return "relocate";
+        case growth_phase::deallocate:
+            return "deallocate";
+    }
+    return "unknown";
+}
+}  // namespace detail
+
+namespace stats_policy {
+// per_type counters, plus the duration of every phase of every growth in
+// per-thread histograms by element type and power of two of the new
+// capacity in bytes; see growth_latency_report().
+struct timed_per_type : per_type {
+    static constexpr bool times_growth = true;
+
+    template <typename T>
+    static void growth_timed(growth_phase phase,
+                             std::size_t capacity_bytes,
+                             std::uint64_t nanoseconds) noexcept {
+        if (capacity_bytes == 0) {
+            return;
+        }
+        auto capacity_bucket = static_cast<std::size_t>(
+            63 - __builtin_clzll(capacity_bytes));
+        std::size_t slot =
+            static_cast<std::size_t>(phase) *
+                detail::growth_histograms::capacity_buckets +
+            capacity_bucket;
+        LAB_07_TRY {
+            // Registering the type and the thread locks a mutex and
+            // allocates.
+            std::size_t type_id = detail::growth_type_id<T>();
+            if (type_id == detail::growth_histograms::max_types) {
+                return;
+            }
+            detail::thread_growth_histograms::current().record(type_id, slot,
+                                                               nanoseconds);
+        }
+        LAB_07_CATCH(...) {
+            // Dropped: no memory or no lock for the histogram.
+        }
+    }
+};
+}  // namespace stats_policy
+
+// Merges the histograms of all threads, including those that exited.
+inline std::vector<growth_latency> growth_latency_report() {
+    return detail::growth_registry::instance().report();
+}
+
+// Writes the merged histograms to `out` as JSON lines with the count and
+// the 50th, 99th, 99.9th percentiles and maximum in nanoseconds.
+inline void dump_growth_latency(std::FILE *out) {
+    for (const growth_latency &entry : growth_latency_report()) {
+        const latency_histogram &histogram = entry.histogram;
+        std::fprintf(
+            out,
+            "{\"type\": \"%s\", \"phase\": \"%s\", \"capacity_bytes_min\": "
+            "%zu, \"count\": %llu, \"p50_ns\": %llu, \"p99_ns\": %llu, "
+            "\"p999_ns\": %llu, \"max_ns\": %llu}\n",
+            entry.type.c_str(), detail::phase_name(entry.phase),
+            entry.capacity_bytes_min,
+            static_cast<unsigned long long>(histogram.count()),
+            static_cast<unsigned long long>(histogram.value_at_percentile(50)),
+            static_cast<unsigned long long>(histogram.value_at_percentile(99)),
+            static_cast<unsigned long long>(
+                histogram.value_at_percentile(99.9)),
+            static_cast<unsigned long long>(
+                histogram.value_at_percentile(100)));
+    }
+}
+
+}  // namespace lab_07
+
+#endif  // LATENCY_H_
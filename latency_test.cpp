@@ -0,0 +1,90 @@
+#include "latency.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+#include "doctest.h"
+#include "vector.h"
+
+namespace {
+struct timed_element {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::int64_t value = 0;
+};
+
+using timed_vector = lab_07::vector<timed_element,
+                                    std::allocator<timed_element>,
+                                    lab_07::exception_policy::strong,
+                                    lab_07::stats_policy::timed_per_type>;
+
+std::uint64_t growths(lab_07::growth_phase phase) {
+    std::uint64_t total = 0;
+    for (const lab_07::growth_latency &entry :
+         lab_07::growth_latency_report()) {
+        if (entry.type == typeid(timed_element).name() &&
+            entry.phase == phase) {
+            total += entry.histogram.count();
+        }
+    }
+    return total;
+}
+}  // namespace
+
+TEST_CASE("latency_histogram buckets are within an eighth of the value") {
+    using lab_07::latency_histogram;
+    for (std::uint64_t value : {0ULL, 7ULL, 8ULL, 100ULL, 12'345ULL,
+                                987'654'321ULL}) {
+        std::size_t bucket = latency_histogram::bucket_of(value);
+        CHECK(latency_histogram::lower_bound(bucket) <= value);
+        CHECK(latency_histogram::upper_bound(bucket) >= value);
+        CHECK(latency_histogram::upper_bound(bucket) -
+                  latency_histogram::lower_bound(bucket) <=
+              value / 8);
+    }
+
+    latency_histogram histogram;
+    for (std::uint64_t value = 1; value <= 100; value++) {
+        histogram.record(value * 1'000);
+    }
+    CHECK(histogram.count() == 100);
+    CHECK(histogram.value_at_percentile(50) >= 50'000);
+    CHECK(histogram.value_at_percentile(50) <= 50'000 * 9 / 8);
+    CHECK(histogram.value_at_percentile(100) >= 100'000);
+}
+
+TEST_CASE("timed_per_type records every growth phase across threads") {
+    std::uint64_t allocations_before = growths(lab_07::growth_phase::allocate);
+    std::uint64_t relocations_before = growths(lab_07::growth_phase::relocate);
+    std::uint64_t deallocations_before =
+        growths(lab_07::growth_phase::deallocate);
+    auto fill = [] {
+        timed_vector v;
+        for (std::int64_t value = 0; value < 1'000; value++) {
+            v.push_back(timed_element{value});
+        }
+    };
+    fill();
+    std::thread worker(fill);
+    worker.join();
+
+    // Capacities 1, 2, ..., 1024: 11 allocations, 10 of them reallocations.
+    CHECK(growths(lab_07::growth_phase::allocate) - allocations_before == 22);
+    CHECK(growths(lab_07::growth_phase::relocate) - relocations_before == 20);
+    CHECK(growths(lab_07::growth_phase::deallocate) - deallocations_before ==
+          20);
+
+    for (const lab_07::growth_latency &entry :
+         lab_07::growth_latency_report()) {
+        if (entry.type == typeid(timed_element).name()) {
+            CHECK(entry.capacity_bytes_min % sizeof(timed_element) == 0);
+        }
+    }
+
+    std::FILE *out = std::tmpfile();
+    REQUIRE(out != nullptr);
+    lab_07::dump_growth_latency(out);
+    CHECK(std::ftell(out) > 0);
+    std::fclose(out);
+}
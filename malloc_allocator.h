@@ -0,0 +1,65 @@
+#ifndef MALLOC_ALLOCATOR_H_
+#define MALLOC_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include "exceptions.h"
+
+namespace lab_07 {
+// Allocator over std::malloc/std::free, so buffers can be exchanged with C
+// libraries through vector::release() and vector::adopt().
+template <typename T>
+struct malloc_allocator {
+    static_assert(alignof(T) <= alignof(std::max_align_t));
+
+    using value_type = T;
+
+    malloc_allocator() noexcept = default;
+
+    template <typename U>
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    malloc_allocator(const malloc_allocator<U> &) noexcept {
+    }
+
+    T *allocate(std::size_t count) {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            LAB_07_THROW(std::bad_array_new_length());
+        }
+        void *result = std::malloc(count * sizeof(T));
+        if (result == nullptr) {
+            LAB_07_THROW(std::bad_alloc());
+        }
+        return static_cast<T *>(result);
+    }
+
+    // Returns nullptr instead of throwing; used by the try_* members of
+    // vector.
+    T *try_allocate(std::size_t count) noexcept {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            return nullptr;
+        }
+        return static_cast<T *>(std::malloc(count * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t) noexcept {
+        std::free(ptr);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const malloc_allocator<T> &,
+                const malloc_allocator<U> &) noexcept {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const malloc_allocator<T> &,
+                const malloc_allocator<U> &) noexcept {
+    return false;
+}
+
+}  // namespace lab_07
+
+#endif  // MALLOC_ALLOCATOR_H_
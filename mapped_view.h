@@ -0,0 +1,193 @@
+#ifndef MAPPED_VIEW_H_
+#define MAPPED_VIEW_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "serialize.h"
+
+namespace lab_07 {
+enum class access_pattern { normal, sequential, random, willneed };
+
+// Read-only view of a vector serialized by serialize(), mapped from its file
+// instead of read. Pages are loaded on first access.
+template <typename T>
+class mapped_view {
+    static_assert(std::is_trivially_copyable_v<T>);
+    void *mapping_ = nullptr;
+    std::size_t mapping_size_ = 0;
+    const T *data_ = nullptr;
+    std::size_t size_ = 0;
+    std::uint64_t checksum_ = 0;
+
+    void map(int fd) {
+        struct stat file_stat {};
+        if (fstat(fd, &file_stat) != 0) {
+            detail::throw_errno("fstat");
+        }
+        auto file_size = static_cast<std::size_t>(file_stat.st_size);
+        if (file_size < sizeof(serialized_header)) {
+            throw serialization_error("not a serialized vector");
+        }
+        mapping_ = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            detail::throw_errno("mmap");
+        }
+        mapping_size_ = file_size;
+        try {
+            serialized_header header;
+            std::memcpy(&header, mapping_, sizeof(header));
+            detail::validate_header(header, serialized_header::raw_payload,
+                                    sizeof(T));
+            if (header.payload_bytes >
+                file_size - sizeof(serialized_header)) {
+                throw serialization_error("serialized vector is truncated");
+            }
+            data_ = reinterpret_cast<const T *>(
+                static_cast<const char *>(mapping_) + sizeof(header));
+            size_ = static_cast<std::size_t>(header.count);
+            checksum_ = header.checksum;
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    void unmap() noexcept {
+        if (mapping_ != nullptr) {
+            munmap(mapping_, mapping_size_);
+        }
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+public:
+    using value_type = T;
+    using const_iterator = const T *;
+
+    mapped_view() noexcept = default;
+
+    // Maps the serialized vector starting at the beginning of `fd`. The file
+    // descriptor may be closed afterwards.
+    explicit mapped_view(int fd) {
+        map(fd);
+    }
+
+    explicit mapped_view(const char *path) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            detail::throw_errno("open");
+        }
+        try {
+            map(fd);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+    }
+
+    mapped_view(const mapped_view &) = delete;
+    mapped_view &operator=(const mapped_view &) = delete;
+
+    mapped_view(mapped_view &&other) noexcept
+        : mapping_(std::exchange(other.mapping_, nullptr)),
+          mapping_size_(std::exchange(other.mapping_size_, 0)),
+          data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          checksum_(other.checksum_) {
+    }
+
+    mapped_view &operator=(mapped_view &&other) noexcept {
+        if (this != &other) {
+            unmap();
+            std::swap(mapping_, other.mapping_);
+            std::swap(mapping_size_, other.mapping_size_);
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+            std::swap(checksum_, other.checksum_);
+        }
+        return *this;
+    }
+
+    ~mapped_view() noexcept {
+        unmap();
+    }
+
+    [[nodiscard]] const T &operator[](std::size_t index) const noexcept {
+        return data_[index];
+    }
+
+    [[nodiscard]] const T &at(std::size_t index) const {
+        if (index >= size_) {
+            throw std::out_of_range("out of range");
+        }
+        return data_[index];
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return size_;
+    }
+
+    [[nodiscard]] const T *data() const noexcept {
+        return data_;
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return data_;
+    }
+
+    [[nodiscard]] const_iterator end() const noexcept {
+        return data_ + size_;
+    }
+
+    // Tells the kernel how the elements are going to be accessed.
+    void advise(access_pattern pattern) const {
+        if (mapping_ == nullptr) {
+            return;
+        }
+        int advice = MADV_NORMAL;
+        switch (pattern) {
+            case access_pattern::normal:
+                advice = MADV_NORMAL;
+                break;
+            case access_pattern::sequential:
+                advice = MADV_SEQUENTIAL;
+                break;
+            case access_pattern::random:
+                advice = MADV_RANDOM;
+                break;
+            case access_pattern::willneed:
+                advice = MADV_WILLNEED;
+                break;
+        }
+        if (madvise(mapping_, mapping_size_, advice) != 0) {
+            detail::throw_errno("madvise");
+        }
+    }
+
+    // Reads every element to check the payload against the header's
+    // checksum. Not done on construction, as it faults in the whole file.
+    [[nodiscard]] bool verify_checksum() const noexcept {
+        detail::checksum payload_checksum;
+        payload_checksum.update(data_, size_ * sizeof(T));
+        return payload_checksum.value() == checksum_;
+    }
+};
+
+}  // namespace lab_07
+
+#endif  // MAPPED_VIEW_H_
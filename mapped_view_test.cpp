@@ -0,0 +1,71 @@
+#include "mapped_view.h"
+#include <unistd.h>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include "doctest.h"
+#include "serialize.h"
+#include "test_temporary_file.h"
+#include "vector.h"
+
+TEST_CASE("mapped_view exposes a serialized vector in place") {
+    TemporaryFile file;
+    lab_07::vector<std::uint64_t> values;
+    for (std::uint64_t i = 0; i < 100'000; i++) {
+        values.push_back(std::uint64_t{i});
+    }
+    lab_07::serialize(file.fd(), values);
+
+    lab_07::mapped_view<std::uint64_t> view(file.path());
+    REQUIRE(view.size() == values.size());
+    CHECK(!view.empty());
+    CHECK(view[0] == 0);
+    CHECK(view.at(99'999) == 99'999);
+    CHECK_THROWS_AS(static_cast<void>(view.at(100'000)), std::out_of_range);
+    view.advise(lab_07::access_pattern::sequential);
+    CHECK(std::accumulate(view.begin(), view.end(), std::uint64_t{0}) ==
+          std::uint64_t{99'999} * 100'000 / 2);
+    view.advise(lab_07::access_pattern::random);
+    view.advise(lab_07::access_pattern::willneed);
+    CHECK(view.verify_checksum());
+
+    lab_07::mapped_view<std::uint64_t> moved = std::move(view);
+    // NOLINTNEXTLINE(bugprone-use-after-move)
+    CHECK(view.empty());
+    CHECK(moved[12'345] == 12'345);
+
+    std::uint64_t corrupted = 0;
+    REQUIRE(pwrite(file.fd(), &corrupted, sizeof(corrupted),
+                   sizeof(lab_07::serialized_header) + 8) ==
+            sizeof(corrupted));
+    CHECK(moved[1] == 0);
+    CHECK(!moved.verify_checksum());
+}
+
+TEST_CASE("mapped_view rejects incompatible files") {
+    TemporaryFile file;
+
+    SUBCASE("empty file") {
+        CHECK_THROWS_AS(lab_07::mapped_view<int>(file.fd()),
+                        lab_07::serialization_error);
+    }
+
+    SUBCASE("another element type") {
+        lab_07::serialize(file.fd(), lab_07::vector<int>(10));
+        CHECK_THROWS_AS(lab_07::mapped_view<std::int64_t>(file.fd()),
+                        lab_07::serialization_error);
+    }
+
+    SUBCASE("elements that are not stored raw") {
+        lab_07::serialize(file.fd(), lab_07::vector<std::string>(10));
+        CHECK_THROWS_AS(lab_07::mapped_view<std::int64_t>(file.fd()),
+                        lab_07::serialization_error);
+    }
+
+    SUBCASE("truncated payload") {
+        lab_07::serialize(file.fd(), lab_07::vector<int>(1'000));
+        REQUIRE(ftruncate(file.fd(), 1'000) == 0);
+        CHECK_THROWS_AS(lab_07::mapped_view<int>(file.fd()),
+                        lab_07::serialization_error);
+    }
+}
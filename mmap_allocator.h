@@ -0,0 +1,133 @@
+#ifndef MMAP_ALLOCATOR_H_
+#define MMAP_ALLOCATOR_H_
+
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include "pages.h"
+
+namespace lab_07 {
+enum mmap_options : unsigned {
+    mmap_default = 0,
+    // Fault in every page of the buffer when it is allocated or grown, so the
+    // first write to reserved capacity does not page-fault.
+    mmap_prefault = 1,
+    // Additionally mlock the buffer; allocation fails if it cannot be locked.
+    mmap_lock = 2,
+};
+
+// Allocator for large buffers: requests of at least `mmap_threshold` bytes are
+// served by anonymous mappings and grown with mremap(MREMAP_MAYMOVE), so the
+// kernel moves page tables instead of copying data. Smaller requests go to
+// std::allocator unless `Options` asks for prefaulting or locking, in which
+// case every buffer is mapped.
+template <typename T, unsigned Options = mmap_default>
+struct mmap_allocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = mmap_allocator<U, Options>;
+    };
+
+    static constexpr std::size_t mmap_threshold = 64 * 1024;
+
+    mmap_allocator() noexcept = default;
+
+    template <typename U>
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    mmap_allocator(const mmap_allocator<U, Options> &) noexcept {
+    }
+
+    T *allocate(std::size_t count) {
+        if (!is_mapped(count)) {
+            return std::allocator<T>().allocate(count);
+        }
+        std::size_t length = detail::round_up_to_pages(bytes(count));
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+        if (Options & (mmap_prefault | mmap_lock)) {
+            flags |= MAP_POPULATE;
+        }
+#endif
+        void *result =
+            mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (result == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        if ((Options & mmap_lock) && mlock(result, length) != 0) {
+            munmap(result, length);
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(result);
+    }
+
+    void deallocate(T *ptr, std::size_t count) noexcept {
+        if (!is_mapped(count)) {
+            std::allocator<T>().deallocate(ptr, count);
+            return;
+        }
+        munmap(ptr, detail::round_up_to_pages(bytes(count)));
+    }
+
+    // Returns a buffer of `new_count` elements whose first
+    // min(old_count, new_count) elements are bytewise equal to the old ones.
+    // On failure throws and leaves the old buffer intact.
+    T *reallocate(T *ptr, std::size_t old_count, std::size_t new_count) {
+#ifdef __linux__
+        if (is_mapped(old_count) && is_mapped(new_count)) {
+            void *result =
+                mremap(ptr, detail::round_up_to_pages(bytes(old_count)),
+                       detail::round_up_to_pages(bytes(new_count)),
+                       MREMAP_MAYMOVE);
+            if (result == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            if ((Options & (mmap_prefault | mmap_lock)) &&
+                new_count > old_count) {
+                detail::prefault(static_cast<char *>(result) + bytes(old_count),
+                                 bytes(new_count - old_count));
+            }
+            return static_cast<T *>(result);
+        }
+#endif
+        T *result = allocate(new_count);
+        std::memcpy(static_cast<void *>(result), static_cast<void *>(ptr),
+                    bytes(std::min(old_count, new_count)));
+        deallocate(ptr, old_count);
+        return result;
+    }
+
+private:
+    static std::size_t bytes(std::size_t count) {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return count * sizeof(T);
+    }
+
+    static bool is_mapped(std::size_t count) noexcept {
+        return Options != mmap_default ||
+               count >= (mmap_threshold + sizeof(T) - 1) / sizeof(T);
+    }
+};
+
+template <typename T, typename U, unsigned Options>
+bool operator==(const mmap_allocator<T, Options> &,
+                const mmap_allocator<U, Options> &) noexcept {
+    return true;
+}
+
+template <typename T, typename U, unsigned Options>
+bool operator!=(const mmap_allocator<T, Options> &,
+                const mmap_allocator<U, Options> &) noexcept {
+    return false;
+}
+
+}  // namespace lab_07
+
+#endif  // MMAP_ALLOCATOR_H_
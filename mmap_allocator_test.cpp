@@ -0,0 +1,174 @@
+#include "mmap_allocator.h"
+#include <sys/mman.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "doctest.h"
+#include "vector.h"
+
+namespace {
+std::size_t reallocate_calls = 0;
+
+template <typename T>
+struct ReallocatingAllocator : lab_07::mmap_allocator<T> {
+    using value_type = T;
+
+    T *reallocate(T *ptr, std::size_t old_count, std::size_t new_count) {
+        reallocate_calls++;
+        return lab_07::mmap_allocator<T>::reallocate(ptr, old_count,
+                                                     new_count);
+    }
+};
+
+// Always moves the buffer when reallocating, freeing the old one.
+template <typename T>
+struct MovingAllocator : std::allocator<T> {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = MovingAllocator<U>;
+    };
+
+    T *reallocate(T *ptr, std::size_t old_count, std::size_t new_count) {
+        reallocate_calls++;
+        T *result = this->allocate(new_count);
+        std::memcpy(static_cast<void *>(result), ptr, old_count * sizeof(T));
+        this->deallocate(ptr, old_count);
+        return result;
+    }
+};
+
+template <typename T>
+std::size_t resident_pages(const T *data, std::size_t count) {
+    auto begin = reinterpret_cast<std::uintptr_t>(data);
+    std::size_t page = lab_07::detail::page_size();
+    std::size_t length = lab_07::detail::round_up_to_pages(count * sizeof(T));
+    std::vector<unsigned char> residency(length / page);
+    REQUIRE(mincore(reinterpret_cast<void *>(begin - begin % page), length,
+                    residency.data()) == 0);
+    std::size_t result = 0;
+    for (unsigned char page_state : residency) {
+        result += page_state & 1U;
+    }
+    return result;
+}
+}  // namespace
+
+TEST_CASE("mmap_allocator keeps contents when growing past threshold") {
+    lab_07::vector<std::uint64_t, lab_07::mmap_allocator<std::uint64_t>> v;
+    for (std::uint64_t i = 0; i < 100'000; i++) {
+        v.push_back(std::uint64_t{i});
+    }
+    CHECK(v.capacity() == 131'072);
+    v.reserve(1'000'000);
+    CHECK(v.capacity() == 1'048'576);
+    v.resize(300'000, std::uint64_t{7});
+    REQUIRE(v.size() == 300'000);
+    for (std::size_t i = 0; i < 100'000; i++) {
+        REQUIRE(v[i] == i);
+    }
+    for (std::size_t i = 100'000; i < 300'000; i++) {
+        REQUIRE(v[i] == 7);
+    }
+}
+
+TEST_CASE("reallocate is used only for trivially relocatable elements") {
+    SUBCASE("trivially copyable") {
+        reallocate_calls = 0;
+        lab_07::vector<int, ReallocatingAllocator<int>> v;
+        for (int i = 0; i < 5; i++) {
+            v.push_back(int{i});
+        }
+        v.resize(20);
+        v.reserve(100);
+        // 1 -> 2 -> 4 -> 8, then 32 and 128.
+        CHECK(reallocate_calls == 5);
+        REQUIRE(v.size() == 20);
+        CHECK(v.capacity() == 128);
+        for (int i = 0; i < 5; i++) {
+            CHECK(v[i] == i);
+        }
+        CHECK(v[19] == 0);
+    }
+
+    SUBCASE("not trivially copyable") {
+        reallocate_calls = 0;
+        lab_07::vector<std::string, ReallocatingAllocator<std::string>> v;
+        for (int i = 0; i < 5; i++) {
+            v.push_back(std::string(100U, 'x'));
+        }
+        v.reserve(100);
+        CHECK(reallocate_calls == 0);
+        CHECK(v[4] == std::string(100U, 'x'));
+    }
+}
+
+TEST_CASE("push_back of an own element survives a moving reallocate") {
+    reallocate_calls = 0;
+    lab_07::vector<long, MovingAllocator<long>> v;
+    v.push_back(42L);
+    while (v.size() < 16) {
+        v.push_back(v[0]);
+    }
+    v.resize(40, v[15]);
+    // 1 -> 2 -> 4 -> 8 -> 16, then 64.
+    CHECK(reallocate_calls == 5);
+    REQUIRE(v.size() == 40);
+    for (std::size_t index = 0; index < v.size(); index++) {
+        CHECK(v[index] == 42L);
+    }
+}
+
+TEST_CASE("mmap_allocator prefaults reserved capacity") {
+    using Alloc = lab_07::mmap_allocator<std::uint64_t, lab_07::mmap_prefault>;
+    lab_07::vector<std::uint64_t, Alloc> v(1);
+    v.reserve(1 << 16);
+    CHECK(resident_pages(&v[0], v.capacity()) ==
+          v.capacity() * sizeof(std::uint64_t) / lab_07::detail::page_size());
+
+    v.resize(1 << 16);
+    v.push_back(std::uint64_t{1});
+    CHECK(resident_pages(&v[0], v.capacity()) ==
+          v.capacity() * sizeof(std::uint64_t) / lab_07::detail::page_size());
+}
+
+TEST_CASE("mmap_allocator reallocate shrinks prefaulted buffers") {
+    lab_07::mmap_allocator<std::uint64_t, lab_07::mmap_prefault> allocator;
+    std::size_t page_elements =
+        lab_07::detail::page_size() / sizeof(std::uint64_t);
+    std::uint64_t *data = allocator.allocate(4 * page_elements);
+    data[page_elements] = 7;
+    data = allocator.reallocate(data, 4 * page_elements, 2 * page_elements);
+    CHECK(data[page_elements] == 7);
+    CHECK(resident_pages(data, 2 * page_elements) == 2);
+    allocator.deallocate(data, 2 * page_elements);
+}
+
+TEST_CASE("mmap_allocator locks buffers") {
+    using Alloc = lab_07::mmap_allocator<int, lab_07::mmap_lock>;
+    lab_07::vector<int, Alloc> v(4);
+    v.reserve(1 << 12);
+    CHECK(resident_pages(&v[0], v.capacity()) ==
+          v.capacity() * sizeof(int) / lab_07::detail::page_size());
+    v.resize(v.capacity() + 1, 3);
+    CHECK(v[v.size() - 1] == 3);
+}
+
+TEST_CASE("page_faults counts first touch of fresh pages") {
+    std::size_t length = 64 * lab_07::detail::page_size();
+    void *data = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    REQUIRE(data != MAP_FAILED);
+    lab_07::page_fault_counts before = lab_07::page_faults();
+    for (std::size_t offset = 0; offset < length;
+         offset += lab_07::detail::page_size()) {
+        static_cast<volatile char *>(data)[offset] = 1;
+    }
+    lab_07::page_fault_counts after = lab_07::page_faults();
+    CHECK(after.minor + after.major - before.minor - before.major >= 64);
+    munmap(data, length);
+}
@@ -0,0 +1,66 @@
+#ifndef PAGES_H_
+#define PAGES_H_
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace lab_07 {
+namespace detail {
+inline std::size_t page_size() noexcept {
+    static const std::size_t size =
+        static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+inline std::size_t round_up_to_pages(std::size_t bytes) noexcept {
+    return (bytes + page_size() - 1) / page_size() * page_size();
+}
+
+// Makes the pages spanning [data, data + length) resident. Bytes inside the
+// range may be overwritten, so it must not hold live objects; bytes outside
+// it are preserved.
+inline void prefault(char *data, std::size_t length) noexcept {
+    if (length == 0) {
+        return;
+    }
+#ifdef MADV_POPULATE_WRITE
+    char *first_page = data - reinterpret_cast<std::uintptr_t>(data) %
+                                  page_size();
+    if (madvise(first_page, static_cast<std::size_t>(data - first_page) +
+                                length,
+                MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    *static_cast<volatile char *>(data) = 0;
+    for (std::size_t offset = page_size() -
+                              reinterpret_cast<std::uintptr_t>(data) %
+                                  page_size();
+         offset < length; offset += page_size()) {
+        *static_cast<volatile char *>(data + offset) = 0;
+    }
+}
+}  // namespace detail
+
+struct page_fault_counts {
+    long minor = 0;
+    long major = 0;
+};
+
+// Page faults incurred so far by the calling thread (by the whole process
+// where per-thread accounting is unavailable).
+inline page_fault_counts page_faults() noexcept {
+    rusage usage{};
+#ifdef RUSAGE_THREAD
+    getrusage(RUSAGE_THREAD, &usage);
+#else
+    getrusage(RUSAGE_SELF, &usage);
+#endif
+    return page_fault_counts{usage.ru_minflt, usage.ru_majflt};
+}
+}  // namespace lab_07
+
+#endif  // PAGES_H_
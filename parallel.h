@@ -0,0 +1,175 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lab_07 {
+namespace detail {
+inline std::atomic<std::size_t> parallel_min_bytes{
+    std::numeric_limits<std::size_t>::max()};
+inline std::atomic<unsigned> parallel_threads{0};
+
+// Process-wide pool running one job of independent tasks at a time. The
+// calling thread takes part in the job. Tasks must not throw.
+class thread_pool {
+    std::mutex job_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::vector<std::thread> workers_;
+    const std::function<void(std::size_t)> *job_ = nullptr;
+    std::size_t tasks_ = 0;
+    std::size_t next_task_ = 0;
+    std::size_t finished_tasks_ = 0;
+    bool stop_ = false;
+
+    static bool &is_worker() noexcept {
+        thread_local bool result = false;
+        return result;
+    }
+
+    void work() {
+        is_worker() = true;
+        std::unique_lock lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] {
+                return stop_ || (job_ != nullptr && next_task_ < tasks_);
+            });
+            if (stop_) {
+                return;
+            }
+            run_one(lock);
+        }
+    }
+
+    // Runs the next task of the current job with `lock` released.
+    void run_one(std::unique_lock<std::mutex> &lock) {
+        std::size_t task = next_task_++;
+        const auto *job = job_;
+        lock.unlock();
+        (*job)(task);
+        lock.lock();
+        if (++finished_tasks_ == tasks_) {
+            done_.notify_all();
+        }
+    }
+
+    void start_workers(std::size_t count) {
+        std::lock_guard lock(mutex_);
+        while (workers_.size() < count) {
+            workers_.emplace_back([this] { work(); });
+        }
+    }
+
+public:
+    thread_pool() = default;
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    static thread_pool &instance() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    // Calls `task(0)`, ..., `task(tasks - 1)` on up to `threads` threads and
+    // waits for all of them. Falls back to the calling thread when invoked
+    // from a task or while another job is running.
+    void run(std::size_t tasks,
+             unsigned threads,
+             const std::function<void(std::size_t)> &task) {
+        std::unique_lock job_lock(job_mutex_, std::try_to_lock);
+        if (tasks <= 1 || threads <= 1 || is_worker() ||
+            !job_lock.owns_lock()) {
+            for (std::size_t index = 0; index < tasks; index++) {
+                task(index);
+            }
+            return;
+        }
+        start_workers(std::min<std::size_t>(threads, tasks) - 1);
+        std::unique_lock lock(mutex_);
+        job_ = &task;
+        tasks_ = tasks;
+        next_task_ = 0;
+        finished_tasks_ = 0;
+        wake_.notify_all();
+        while (next_task_ < tasks_) {
+            run_one(lock);
+        }
+        done_.wait(lock, [&] { return finished_tasks_ == tasks_; });
+        job_ = nullptr;
+    }
+};
+
+inline unsigned parallel_thread_count() noexcept {
+    unsigned threads = parallel_threads.load(std::memory_order_relaxed);
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    return threads;
+}
+
+// Number of chunks to split a section of `count` elements of `element_size`
+// bytes into; 1 means the section is processed on the calling thread.
+inline std::size_t parallel_chunks(std::size_t count,
+                                   std::size_t element_size) noexcept {
+    if (count < 2 || count > std::numeric_limits<std::size_t>::max() /
+                                 element_size ||
+        count * element_size <
+            parallel_min_bytes.load(std::memory_order_relaxed)) {
+        return 1;
+    }
+    return std::min<std::size_t>(parallel_thread_count(), count);
+}
+
+// Bounds of chunk `chunk` out of `chunks` equal parts of [begin, end).
+inline std::pair<std::size_t, std::size_t> chunk_bounds(
+    std::size_t begin,
+    std::size_t end,
+    std::size_t chunk,
+    std::size_t chunks) noexcept {
+    std::size_t count = end - begin;
+    return {begin + count / chunks * chunk + std::min(chunk, count % chunks),
+            begin + count / chunks * (chunk + 1) +
+                std::min(chunk + 1, count % chunks)};
+}
+}  // namespace detail
+
+// Makes vectors construct sections of at least `min_bytes` bytes (in
+// constructors, resize and copying) concurrently on up to `threads` threads,
+// 0 meaning std::thread::hardware_concurrency(). Each thread first-touches
+// the pages it constructs. Element constructors must be safe to run
+// concurrently.
+inline void enable_parallel_construction(std::size_t min_bytes,
+                                         unsigned threads = 0) noexcept {
+    detail::parallel_threads.store(threads, std::memory_order_relaxed);
+    detail::parallel_min_bytes.store(min_bytes, std::memory_order_relaxed);
+}
+
+inline void disable_parallel_construction() noexcept {
+    detail::parallel_min_bytes.store(std::numeric_limits<std::size_t>::max(),
+                                     std::memory_order_relaxed);
+}
+
+}  // namespace lab_07
+
+#endif  // PARALLEL_H_
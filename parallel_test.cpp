@@ -0,0 +1,138 @@
+#include "parallel.h"
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include "doctest.h"
+#include "vector.h"
+
+namespace {
+struct ParallelConstructionScope {
+    explicit ParallelConstructionScope(unsigned threads) {
+        lab_07::enable_parallel_construction(0, threads);
+    }
+    ParallelConstructionScope(const ParallelConstructionScope &) = delete;
+    ParallelConstructionScope &operator=(const ParallelConstructionScope &) =
+        delete;
+    ~ParallelConstructionScope() {
+        lab_07::disable_parallel_construction();
+    }
+};
+
+struct artificial_exception {};
+
+std::atomic<int> alive{0};
+std::atomic<int> constructions_until_throw{-1};
+
+struct Counted {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::string data = std::string(100U, 'x');
+
+    Counted() {
+        if (constructions_until_throw.fetch_sub(1) == 0) {
+            throw artificial_exception();
+        }
+        alive++;
+    }
+    Counted(const Counted &other) : data(other.data) {
+        if (constructions_until_throw.fetch_sub(1) == 0) {
+            throw artificial_exception();
+        }
+        alive++;
+    }
+    Counted(Counted &&other) noexcept : data(std::move(other.data)) {
+        alive++;
+    }
+    Counted &operator=(const Counted &) = delete;
+    Counted &operator=(Counted &&) = default;
+    ~Counted() {
+        alive--;
+    }
+};
+}  // namespace
+
+TEST_CASE("chunk_bounds covers the range without gaps") {
+    std::size_t expected_begin = 3;
+    for (std::size_t chunk = 0; chunk < 4; chunk++) {
+        auto [begin, end] = lab_07::detail::chunk_bounds(3, 13, chunk, 4);
+        CHECK(begin == expected_begin);
+        CHECK(end - begin >= 2);
+        CHECK(end - begin <= 3);
+        expected_begin = end;
+    }
+    CHECK(expected_begin == 13);
+}
+
+TEST_CASE("parallel construction initializes every element") {
+    ParallelConstructionScope scope(4);
+
+    lab_07::vector<int> zeros(100'001);
+    lab_07::vector<std::string> strings(1'000, std::string(50U, 's'));
+    lab_07::vector<int> resized;
+    resized.resize(10'000, 7);
+    resized.resize(20'000);
+
+    for (std::size_t i = 0; i < zeros.size(); i++) {
+        REQUIRE(zeros[i] == 0);
+    }
+    for (std::size_t i = 0; i < strings.size(); i++) {
+        REQUIRE(strings[i] == std::string(50U, 's'));
+    }
+    for (std::size_t i = 0; i < resized.size(); i++) {
+        REQUIRE(resized[i] == (i < 10'000 ? 7 : 0));
+    }
+}
+
+TEST_CASE("parallel construction keeps strong exception safety") {
+    ParallelConstructionScope scope(4);
+
+    SUBCASE("in constructor") {
+        constructions_until_throw = 777;
+        CHECK_THROWS_AS(lab_07::vector<Counted>(1'000), artificial_exception);
+        CHECK(alive == 0);
+    }
+
+    SUBCASE("in resize with reallocation") {
+        {
+            lab_07::vector<Counted> v(10);
+            constructions_until_throw = 500;
+            CHECK_THROWS_AS(v.resize(1'000), artificial_exception);
+            REQUIRE(v.size() == 10);
+            CHECK(v.capacity() == 16);
+            CHECK(alive == 10);
+            CHECK(v[9].data == std::string(100U, 'x'));
+        }
+        CHECK(alive == 0);
+    }
+
+    constructions_until_throw = -1;
+}
+
+TEST_CASE("parallel copy keeps strong exception safety") {
+    ParallelConstructionScope scope(4);
+    {
+        lab_07::vector<Counted> source(1'000);
+        source[999].data = "last";
+
+        SUBCASE("copy-construct") {
+            lab_07::vector<Counted> copy = source;
+            REQUIRE(copy.size() == 1'000);
+            CHECK(copy.capacity() == 1'024);
+            CHECK(copy[0].data == std::string(100U, 'x'));
+            CHECK(copy[999].data == "last");
+            CHECK(alive == 2'000);
+        }
+
+        SUBCASE("copy-assign throws") {
+            lab_07::vector<Counted> target(3);
+            target[0].data = "first";
+            constructions_until_throw = 600;
+            CHECK_THROWS_AS(target = source, artificial_exception);
+            REQUIRE(target.size() == 3);
+            CHECK(target.capacity() == 4);
+            CHECK(target[0].data == "first");
+            CHECK(alive == 1'003);
+        }
+    }
+    CHECK(alive == 0);
+    constructions_until_throw = -1;
+}
@@ -0,0 +1,38 @@
+#ifndef PROBES_H_
+#define PROBES_H_
+
+// USDT probes of provider lab_07, emitted when LAB_07_USDT is defined and
+// <sys/sdt.h> (systemtap-sdt-dev) is available; otherwise the probes compile
+// to nothing. The CMake option LAB_07_USDT fails without the header. An
+// enabled probe is a single nop until a tracer attaches:
+//
+//     bpftrace -e 'usdt:./app:lab_07:grow { @[arg3 * arg2] = count(); }'
+//
+// Probes, all with the vector's address as the first argument:
+//     grow(vector, old_capacity, new_capacity, element_size)
+//         every reallocation to a larger buffer
+//     resize_grow(vector, old_capacity, new_capacity, element_size)
+//         resize(), try_resize() or push_back(const T &) outgrowing the
+//         capacity
+//     reserve(vector, old_capacity, new_capacity, element_size)
+//         reserve() or try_reserve() growing the capacity
+//     shrink(vector, old_size, new_size, element_size)
+//         resize() to fewer elements
+//     rollback(vector, capacity, elements, element_size)
+//         construction of `elements` elements threw and was undone
+#if defined(LAB_07_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define LAB_07_PROBES_ENABLED 1
+#define LAB_07_PROBE(name, vector, first, second, element_size)             \
+    DTRACE_PROBE4(lab_07, name, vector, first, second, element_size)
+#endif
+#endif
+
+#ifndef LAB_07_PROBES_ENABLED
+#define LAB_07_PROBES_ENABLED 0
+#define LAB_07_PROBE(name, vector, first, second, element_size) \
+    static_cast<void>(0)
+#endif
+
+#endif  // PROBES_H_
@@ -0,0 +1,509 @@
+#ifndef SERIALIZE_H_
+#define SERIALIZE_H_
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include "vector.h"
+
+namespace lab_07 {
+// Layout of the 64-byte header preceding the elements in a serialized
+// vector. Elements of trivially copyable types follow as raw bytes, so the
+// payload is suitably aligned for them in a page-aligned mapping.
+struct serialized_header {
+    static constexpr char expected_magic[8] = {'L', 'A', 'B', '0',
+                                               '7', 'V', 'E', 'C'};
+    static constexpr std::uint32_t current_version = 1;
+    // Written in host byte order; reads back differently on a host with
+    // another endianness.
+    static constexpr std::uint32_t expected_byte_order = 0x01020304;
+    // The payload is the raw bytes of the elements.
+    static constexpr std::uint32_t raw_payload = 1;
+
+    char magic[8] = {};
+    std::uint32_t version = 0;
+    std::uint32_t byte_order = 0;
+    std::uint32_t flags = 0;
+    std::uint32_t element_size = 0;
+    std::uint64_t count = 0;
+    std::uint64_t payload_bytes = 0;
+    std::uint64_t checksum = 0;
+    std::uint8_t reserved[16] = {};
+};
+static_assert(sizeof(serialized_header) == 64);
+
+class serialization_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+namespace detail {
+// Streaming 64-bit checksum consuming eight bytes per step.
+class checksum {
+    std::uint64_t state_ = 0xcbf29ce484222325ULL;
+    std::uint64_t tail_ = 0;
+    std::size_t tail_bytes_ = 0;
+    std::uint64_t length_ = 0;
+
+    void mix(std::uint64_t word) noexcept {
+        state_ = (state_ ^ word) * 0x100000001b3ULL;
+        state_ ^= state_ >> 29;
+    }
+
+public:
+    void update(const void *data, std::size_t size) noexcept {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        length_ += size;
+        while (tail_bytes_ != 0 && size > 0) {
+            tail_ |= std::uint64_t{*bytes++} << (8 * tail_bytes_++);
+            size--;
+            if (tail_bytes_ == 8) {
+                mix(tail_);
+                tail_ = 0;
+                tail_bytes_ = 0;
+            }
+        }
+        for (; size >= 8; size -= 8, bytes += 8) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, bytes, 8);
+            mix(word);
+        }
+        for (; size > 0; size--) {
+            tail_ |= std::uint64_t{*bytes++} << (8 * tail_bytes_++);
+        }
+    }
+
+    [[nodiscard]] std::uint64_t value() const noexcept {
+        checksum copy = *this;
+        copy.mix(copy.tail_);
+        copy.mix(copy.length_);
+        return copy.state_;
+    }
+};
+
+[[noreturn]] inline void throw_errno(const char *what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+inline void write_all(int fd, const void *data, std::size_t size) {
+    const auto *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("write");
+        }
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+inline void read_all(int fd, void *data, std::size_t size) {
+    auto *bytes = static_cast<char *>(data);
+    while (size > 0) {
+        ssize_t got = ::read(fd, bytes, size);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("read");
+        }
+        if (got == 0) {
+            throw serialization_error("unexpected end of serialized vector");
+        }
+        bytes += got;
+        size -= static_cast<std::size_t>(got);
+    }
+}
+
+inline void pwrite_all(int fd,
+                       const void *data,
+                       std::size_t size,
+                       std::uint64_t offset) {
+    const auto *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written =
+            ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("pwrite");
+        }
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+        offset += static_cast<std::uint64_t>(written);
+    }
+}
+
+inline void pread_all(int fd,
+                      void *data,
+                      std::size_t size,
+                      std::uint64_t offset) {
+    auto *bytes = static_cast<char *>(data);
+    while (size > 0) {
+        ssize_t got = ::pread(fd, bytes, size, static_cast<off_t>(offset));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("pread");
+        }
+        if (got == 0) {
+            throw serialization_error("unexpected end of file");
+        }
+        bytes += got;
+        size -= static_cast<std::size_t>(got);
+        offset += static_cast<std::uint64_t>(got);
+    }
+}
+
+// Creates a file in `directory` that disappears once closed.
+inline int open_temporary_file(const std::string &directory) {
+    int fd = open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd >= 0) {
+        return fd;
+    }
+    std::string path = directory + "/lab07-XXXXXX";
+    fd = mkostemp(path.data(), O_CLOEXEC);
+    if (fd < 0) {
+        throw_errno("mkostemp");
+    }
+    unlink(path.c_str());
+    return fd;
+}
+
+class unique_fd {
+    int fd_;
+
+public:
+    explicit unique_fd(int fd) noexcept : fd_(fd) {
+    }
+
+    unique_fd(const unique_fd &) = delete;
+    unique_fd &operator=(const unique_fd &) = delete;
+
+    unique_fd(unique_fd &&other) noexcept : fd_(std::exchange(other.fd_, -1)) {
+    }
+
+    unique_fd &operator=(unique_fd &&other) noexcept {
+        std::swap(fd_, other.fd_);
+        return *this;
+    }
+
+    ~unique_fd() noexcept {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    [[nodiscard]] int get() const noexcept {
+        return fd_;
+    }
+};
+
+inline serialized_header make_header(std::uint32_t flags,
+                                     std::size_t element_size,
+                                     std::size_t count) noexcept {
+    serialized_header header;
+    std::memcpy(header.magic, serialized_header::expected_magic,
+                sizeof(header.magic));
+    header.version = serialized_header::current_version;
+    header.byte_order = serialized_header::expected_byte_order;
+    header.flags = flags;
+    header.element_size = static_cast<std::uint32_t>(element_size);
+    header.count = count;
+    return header;
+}
+
+// Throws unless `header` describes `count` elements of `element_size` bytes
+// written by a compatible host.
+inline void validate_header(const serialized_header &header,
+                            std::uint32_t flags,
+                            std::size_t element_size) {
+    if (std::memcmp(header.magic, serialized_header::expected_magic,
+                    sizeof(header.magic)) != 0) {
+        throw serialization_error("not a serialized vector");
+    }
+    if (header.version != serialized_header::current_version) {
+        throw serialization_error("unsupported serialized vector version");
+    }
+    if (header.byte_order != serialized_header::expected_byte_order) {
+        throw serialization_error("serialized vector has foreign endianness");
+    }
+    if (header.flags != flags || header.element_size != element_size) {
+        throw serialization_error("serialized vector has another element type");
+    }
+    // Capacities are powers of two, so the largest one is half of the range.
+    if (header.count >
+        std::numeric_limits<std::size_t>::max() / 2 / element_size) {
+        throw serialization_error("serialized vector is too large");
+    }
+    if ((flags & serialized_header::raw_payload) &&
+        header.payload_bytes != header.count * element_size) {
+        throw serialization_error("serialized vector has inconsistent size");
+    }
+}
+
+// Throws unless `fd` holds `payload_bytes` more bytes, so a corrupt header
+// cannot make deserialize() allocate for elements that are not there. Only
+// regular files can be checked; for pipes and sockets a short payload is
+// noticed while reading.
+inline void check_payload_available(int fd, std::uint64_t payload_bytes) {
+    struct stat status {};
+    if (fstat(fd, &status) != 0) {
+        throw_errno("fstat");
+    }
+    if (!S_ISREG(status.st_mode)) {
+        return;
+    }
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset < 0) {
+        throw_errno("lseek");
+    }
+    if (offset > status.st_size ||
+        payload_bytes > static_cast<std::uint64_t>(status.st_size - offset)) {
+        throw serialization_error("serialized vector exceeds the file");
+    }
+}
+
+// Elements reserved up front when reading through serializer<T>. The
+// payload does not tell how many bytes each element takes, so beyond this
+// the vector grows as elements arrive.
+inline constexpr std::size_t max_initial_reserve_bytes = std::size_t{1} << 26;
+}  // namespace detail
+
+// Buffered sink handed to serializer<T>::write. Without a file descriptor it
+// only measures the payload.
+class serial_writer {
+    static constexpr std::size_t buffer_size = 1 << 16;
+    int fd_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t buffered_ = 0;
+    std::uint64_t written_ = 0;
+    detail::checksum checksum_;
+
+public:
+    explicit serial_writer(int fd = -1)
+        : fd_(fd), buffer_(fd >= 0 ? new char[buffer_size] : nullptr) {
+    }
+
+    void write(const void *data, std::size_t size) {
+        checksum_.update(data, size);
+        written_ += size;
+        if (fd_ < 0) {
+            return;
+        }
+        if (buffered_ + size > buffer_size) {
+            flush();
+        }
+        if (size >= buffer_size) {
+            detail::write_all(fd_, data, size);
+            return;
+        }
+        std::memcpy(buffer_.get() + buffered_, data, size);
+        buffered_ += size;
+    }
+
+    template <typename U>
+    void write_value(const U &value) {
+        static_assert(std::is_trivially_copyable_v<U>);
+        write(&value, sizeof(U));
+    }
+
+    void flush() {
+        if (fd_ >= 0 && buffered_ > 0) {
+            detail::write_all(fd_, buffer_.get(), buffered_);
+        }
+        buffered_ = 0;
+    }
+
+    [[nodiscard]] std::uint64_t bytes_written() const noexcept {
+        return written_;
+    }
+
+    [[nodiscard]] std::uint64_t checksum() const noexcept {
+        return checksum_.value();
+    }
+};
+
+// Buffered source handed to serializer<T>::read.
+class serial_reader {
+    static constexpr std::size_t buffer_size = 1 << 16;
+    int fd_;
+    std::uint64_t remaining_;
+    std::unique_ptr<char[]> buffer_{new char[buffer_size]};
+    std::size_t begin_ = 0;
+    std::size_t end_ = 0;
+    detail::checksum checksum_;
+
+public:
+    serial_reader(int fd, std::uint64_t payload_bytes)
+        : fd_(fd), remaining_(payload_bytes) {
+    }
+
+    void read(void *data, std::size_t size) {
+        if (size > remaining_ + (end_ - begin_)) {
+            throw serialization_error("serialized element exceeds payload");
+        }
+        std::size_t total = size;
+        auto *bytes = static_cast<char *>(data);
+        std::size_t from_buffer = std::min(size, end_ - begin_);
+        std::memcpy(bytes, buffer_.get() + begin_, from_buffer);
+        begin_ += from_buffer;
+        bytes += from_buffer;
+        size -= from_buffer;
+        if (size >= buffer_size) {
+            detail::read_all(fd_, bytes, size);
+            remaining_ -= size;
+        } else if (size > 0) {
+            std::size_t chunk =
+                static_cast<std::size_t>(std::min<std::uint64_t>(
+                    buffer_size, remaining_));
+            detail::read_all(fd_, buffer_.get(), chunk);
+            remaining_ -= chunk;
+            std::memcpy(bytes, buffer_.get(), size);
+            begin_ = size;
+            end_ = chunk;
+        }
+        checksum_.update(data, total);
+    }
+
+    template <typename U>
+    U read_value() {
+        static_assert(std::is_trivially_copyable_v<U>);
+        U value;
+        read(&value, sizeof(U));
+        return value;
+    }
+
+    [[nodiscard]] bool exhausted() const noexcept {
+        return remaining_ == 0 && begin_ == end_;
+    }
+
+    [[nodiscard]] std::uint64_t checksum() const noexcept {
+        return checksum_.value();
+    }
+};
+
+// Customization point for element types that are not trivially copyable:
+// specialize with `static void write(serial_writer &, const T &)` and
+// `static T read(serial_reader &)`. Writes go through a buffer, so many
+// small writes cost few syscalls.
+template <typename T, typename = void>
+struct serializer;
+
+template <typename CharT, typename Traits, typename StringAlloc>
+struct serializer<std::basic_string<CharT, Traits, StringAlloc>> {
+    using string_type = std::basic_string<CharT, Traits, StringAlloc>;
+
+    static void write(serial_writer &writer, const string_type &value) {
+        writer.write_value(static_cast<std::uint64_t>(value.size()));
+        writer.write(value.data(), value.size() * sizeof(CharT));
+    }
+
+    static string_type read(serial_reader &reader) {
+        auto size = reader.read_value<std::uint64_t>();
+        string_type value;
+        value.resize(static_cast<std::size_t>(size));
+        reader.read(value.data(), value.size() * sizeof(CharT));
+        return value;
+    }
+};
+
+// Writes `vec` to `fd` as a header followed by the elements. Trivially
+// copyable elements are written straight from the vector's buffer.
+template <typename T, typename Alloc, typename... Policies>
+void serialize(int fd, const vector<T, Alloc, Policies...> &vec) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        serialized_header header = detail::make_header(
+            serialized_header::raw_payload, sizeof(T), vec.size());
+        detail::checksum payload_checksum;
+        payload_checksum.update(vec.data(), vec.size() * sizeof(T));
+        header.payload_bytes = vec.size() * sizeof(T);
+        header.checksum = payload_checksum.value();
+        detail::write_all(fd, &header, sizeof(header));
+        detail::write_all(fd, vec.data(), vec.size() * sizeof(T));
+    } else {
+        // The header precedes the payload, so measure it first.
+        serial_writer measure;
+        for (std::size_t index = 0; index < vec.size(); index++) {
+            serializer<T>::write(measure, vec[index]);
+        }
+        serialized_header header =
+            detail::make_header(0, sizeof(T), vec.size());
+        header.payload_bytes = measure.bytes_written();
+        header.checksum = measure.checksum();
+        detail::write_all(fd, &header, sizeof(header));
+        serial_writer writer(fd);
+        for (std::size_t index = 0; index < vec.size(); index++) {
+            serializer<T>::write(writer, vec[index]);
+        }
+        writer.flush();
+    }
+}
+
+// Reads a vector written by serialize(). Throws serialization_error if the
+// data is malformed, was written for another element type or fails the
+// checksum, and std::system_error on I/O errors.
+template <typename T, typename Alloc = std::allocator<T>>
+vector<T, Alloc> deserialize(int fd, const Alloc &allocator = Alloc()) {
+    serialized_header header;
+    detail::read_all(fd, &header, sizeof(header));
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        detail::validate_header(header, serialized_header::raw_payload,
+                                sizeof(T));
+        detail::check_payload_available(fd, header.payload_bytes);
+        std::size_t count = static_cast<std::size_t>(header.count);
+        std::size_t capacity = calculate_capacity(count);
+        Alloc buffer_allocator = allocator;
+        T *data =
+            capacity == 0 ? nullptr
+                          : std::allocator_traits<Alloc>::allocate(
+                                buffer_allocator, capacity);
+        vector_buffer<T, Alloc> buffer(data, 0, capacity, buffer_allocator);
+        detail::read_all(fd, data, count * sizeof(T));
+        detail::checksum payload_checksum;
+        payload_checksum.update(data, count * sizeof(T));
+        if (payload_checksum.value() != header.checksum) {
+            throw serialization_error("serialized vector checksum mismatch");
+        }
+        return vector<T, Alloc>(vector_buffer<T, Alloc>(
+            buffer.release(), count, capacity, buffer_allocator));
+    } else {
+        detail::validate_header(header, 0, sizeof(T));
+        detail::check_payload_available(fd, header.payload_bytes);
+        vector<T, Alloc> result(allocator);
+        result.reserve(std::min(
+            static_cast<std::size_t>(header.count),
+            std::max<std::size_t>(
+                detail::max_initial_reserve_bytes / sizeof(T), 1)));
+        serial_reader reader(fd, header.payload_bytes);
+        for (std::uint64_t index = 0; index < header.count; index++) {
+            result.push_back(serializer<T>::read(reader));
+        }
+        if (!reader.exhausted() || reader.checksum() != header.checksum) {
+            throw serialization_error("serialized vector checksum mismatch");
+        }
+        return result;
+    }
+}
+
+}  // namespace lab_07
+
+#endif  // SERIALIZE_H_
@@ -0,0 +1,136 @@
+#include "serialize.h"
+#include <unistd.h>
+#include <cstdint>
+#include <string>
+#include "doctest.h"
+#include "test_temporary_file.h"
+#include "vector.h"
+
+namespace {
+struct Point {
+    std::int64_t x;
+    double y;
+    char tag[16];
+};
+}  // namespace
+
+TEST_CASE("serialize round-trips trivially copyable elements") {
+    TemporaryFile file;
+    lab_07::vector<Point> points;
+    for (int i = 0; i < 100'000; i++) {
+        points.push_back(Point{i, i * 0.5, "point"});
+    }
+    lab_07::serialize(file.fd(), points);
+    CHECK(lseek(file.fd(), 0, SEEK_CUR) ==
+          static_cast<off_t>(sizeof(lab_07::serialized_header) +
+                             points.size() * sizeof(Point)));
+    file.rewind();
+
+    lab_07::vector<Point> loaded = lab_07::deserialize<Point>(file.fd());
+    REQUIRE(loaded.size() == points.size());
+    CHECK(loaded.capacity() == 131'072);
+    for (std::size_t i = 0; i < loaded.size(); i++) {
+        REQUIRE(loaded[i].x == points[i].x);
+        REQUIRE(loaded[i].y == points[i].y);
+    }
+    CHECK(std::string(loaded[99'999].tag) == "point");
+}
+
+TEST_CASE("serialize round-trips strings and empty vectors") {
+    TemporaryFile file;
+    lab_07::vector<std::string> strings;
+    for (int i = 0; i < 10'000; i++) {
+        strings.push_back(std::string(static_cast<std::size_t>(i % 100), 'a'));
+    }
+    lab_07::vector<int> empty;
+    lab_07::serialize(file.fd(), strings);
+    lab_07::serialize(file.fd(), empty);
+    file.rewind();
+
+    lab_07::vector<std::string> loaded =
+        lab_07::deserialize<std::string>(file.fd());
+    REQUIRE(loaded.size() == strings.size());
+    for (std::size_t i = 0; i < loaded.size(); i++) {
+        REQUIRE(loaded[i] == strings[i]);
+    }
+    CHECK(lab_07::deserialize<int>(file.fd()).empty());
+}
+
+TEST_CASE("deserialize rejects mismatching data") {
+    TemporaryFile file;
+    lab_07::vector<std::uint32_t> values(1'000, 7);
+    lab_07::serialize(file.fd(), values);
+
+    SUBCASE("another element type") {
+        file.rewind();
+        CHECK_THROWS_AS(lab_07::deserialize<std::uint64_t>(file.fd()),
+                        lab_07::serialization_error);
+    }
+
+    SUBCASE("corrupted payload") {
+        std::uint32_t corrupted = 8;
+        REQUIRE(pwrite(file.fd(), &corrupted, sizeof(corrupted),
+                       sizeof(lab_07::serialized_header) + 400) ==
+                sizeof(corrupted));
+        file.rewind();
+        CHECK_THROWS_AS(lab_07::deserialize<std::uint32_t>(file.fd()),
+                        lab_07::serialization_error);
+    }
+
+    SUBCASE("truncated file") {
+        REQUIRE(ftruncate(file.fd(), 100) == 0);
+        file.rewind();
+        CHECK_THROWS_AS(lab_07::deserialize<std::uint32_t>(file.fd()),
+                        lab_07::serialization_error);
+    }
+}
+
+TEST_CASE("deserialize rejects headers promising more than the file holds") {
+    TemporaryFile file;
+    lab_07::vector<std::string> strings(3, std::string("abc"));
+    lab_07::serialize(file.fd(), strings);
+    lab_07::serialized_header header;
+    REQUIRE(pread(file.fd(), &header, sizeof(header), 0) == sizeof(header));
+
+    SUBCASE("huge raw payload") {
+        header.flags = lab_07::serialized_header::raw_payload;
+        header.element_size = 1;
+        header.count = std::uint64_t{1} << 62;
+        header.payload_bytes = header.count;
+        REQUIRE(pwrite(file.fd(), &header, sizeof(header), 0) ==
+                sizeof(header));
+        file.rewind();
+        CHECK_THROWS_AS(lab_07::deserialize<char>(file.fd()),
+                        lab_07::serialization_error);
+    }
+
+    SUBCASE("count beyond any capacity") {
+        header.flags = lab_07::serialized_header::raw_payload;
+        header.element_size = 1;
+        header.count = ~std::uint64_t{0};
+        header.payload_bytes = header.count;
+        REQUIRE(pwrite(file.fd(), &header, sizeof(header), 0) ==
+                sizeof(header));
+        file.rewind();
+        CHECK_THROWS_AS(lab_07::deserialize<char>(file.fd()),
+                        lab_07::serialization_error);
+    }
+
+    SUBCASE("huge element count") {
+        header.count = std::uint64_t{1} << 40;
+        REQUIRE(pwrite(file.fd(), &header, sizeof(header), 0) ==
+                sizeof(header));
+        file.rewind();
+        CHECK_THROWS_AS(lab_07::deserialize<std::string>(file.fd()),
+                        lab_07::serialization_error);
+    }
+
+    SUBCASE("payload beyond the file") {
+        header.payload_bytes = std::uint64_t{1} << 40;
+        REQUIRE(pwrite(file.fd(), &header, sizeof(header), 0) ==
+                sizeof(header));
+        file.rewind();
+        CHECK_THROWS_AS(lab_07::deserialize<std::string>(file.fd()),
+                        lab_07::serialization_error);
+    }
+}
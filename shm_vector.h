@@ -0,0 +1,338 @@
+#ifndef SHM_VECTOR_H_
+#define SHM_VECTOR_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "serialize.h"
+
+namespace lab_07 {
+namespace detail {
+// Start of a shared memory segment holding a vector. Elements are found at
+// `data_offset` from the start of the segment rather than through a
+// pointer, so every process may map the segment at its own address.
+struct shm_header {
+    static constexpr char expected_magic[8] = {'L', 'A', 'B', '0',
+                                               '7', 'S', 'H', 'M'};
+
+    char magic[8];
+    std::uint32_t element_size;
+    std::uint32_t data_offset;
+    std::atomic<std::uint64_t> size;
+    std::atomic<std::uint64_t> capacity;
+};
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "shared atomics must not rely on process-local locks");
+
+// Mapping of a whole shared memory segment.
+class shm_mapping {
+    int fd_ = -1;
+    void *base_ = nullptr;
+    std::size_t length_ = 0;
+
+public:
+    shm_mapping() noexcept = default;
+
+    shm_mapping(int fd, std::size_t length, bool writable) : fd_(fd) {
+        int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        base_ = mmap(nullptr, length, protection, MAP_SHARED, fd, 0);
+        if (base_ == MAP_FAILED) {
+            base_ = nullptr;
+            close(fd_);
+            throw_errno("mmap");
+        }
+        length_ = length;
+    }
+
+    shm_mapping(const shm_mapping &) = delete;
+    shm_mapping &operator=(const shm_mapping &) = delete;
+
+    shm_mapping(shm_mapping &&other) noexcept
+        : fd_(std::exchange(other.fd_, -1)),
+          base_(std::exchange(other.base_, nullptr)),
+          length_(std::exchange(other.length_, 0)) {
+    }
+
+    shm_mapping &operator=(shm_mapping &&other) noexcept {
+        std::swap(fd_, other.fd_);
+        std::swap(base_, other.base_);
+        std::swap(length_, other.length_);
+        return *this;
+    }
+
+    ~shm_mapping() noexcept {
+        if (base_ != nullptr) {
+            munmap(base_, length_);
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    // Maps `new_length` bytes of the segment, possibly at a new address.
+    void remap(std::size_t new_length) {
+        void *result = mremap(base_, length_, new_length, MREMAP_MAYMOVE);
+        if (result == MAP_FAILED) {
+            throw_errno("mremap");
+        }
+        base_ = result;
+        length_ = new_length;
+    }
+
+    void resize_segment(std::size_t new_length) {
+        if (ftruncate(fd_, static_cast<off_t>(new_length)) != 0) {
+            throw_errno("ftruncate");
+        }
+    }
+
+    [[nodiscard]] shm_header &header() const noexcept {
+        return *static_cast<shm_header *>(base_);
+    }
+
+    [[nodiscard]] char *bytes() const noexcept {
+        return static_cast<char *>(base_);
+    }
+
+    [[nodiscard]] std::size_t length() const noexcept {
+        return length_;
+    }
+};
+
+inline int open_shm(const std::string &name, int flags) {
+    int fd = shm_open(name.c_str(), flags | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        throw_errno("shm_open");
+    }
+    return fd;
+}
+}  // namespace detail
+
+// Vector of trivially copyable elements in a POSIX shared memory segment
+// named `name` (e.g. "/frames"), written by one process and read by any
+// number of shm_reader. Growing the vector enlarges the segment and remaps
+// it; the size is published with release semantics after the elements are
+// written, so readers never see unwritten elements.
+template <typename T>
+class shm_vector {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static constexpr std::size_t data_offset =
+        (sizeof(detail::shm_header) + alignof(T) - 1) / alignof(T) *
+        alignof(T);
+
+    detail::shm_mapping mapping_;
+
+    explicit shm_vector(detail::shm_mapping mapping) noexcept
+        : mapping_(std::move(mapping)) {
+    }
+
+    [[nodiscard]] detail::shm_header &header() const noexcept {
+        return mapping_.header();
+    }
+
+    [[nodiscard]] T *elements() const noexcept {
+        return reinterpret_cast<T *>(mapping_.bytes() + data_offset);
+    }
+
+    void grow(std::size_t new_capacity) {
+        std::size_t new_length = data_offset + new_capacity * sizeof(T);
+        mapping_.resize_segment(new_length);
+        mapping_.remap(new_length);
+        header().capacity.store(new_capacity, std::memory_order_release);
+    }
+
+public:
+    using value_type = T;
+
+    // Creates the segment `name`, which must not exist yet.
+    static shm_vector create(const std::string &name,
+                             std::size_t initial_capacity = 0) {
+        int fd = detail::open_shm(name, O_RDWR | O_CREAT | O_EXCL);
+        std::size_t length = data_offset + initial_capacity * sizeof(T);
+        if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+            int error = errno;
+            close(fd);
+            shm_unlink(name.c_str());
+            errno = error;
+            detail::throw_errno("ftruncate");
+        }
+        try {
+            shm_vector result(detail::shm_mapping(fd, length, true));
+            // Begins the lifetime of the atomics in the fresh segment.
+            auto &header = *new (result.mapping_.bytes()) detail::shm_header;
+            std::memcpy(header.magic, detail::shm_header::expected_magic,
+                        sizeof(header.magic));
+            header.element_size = sizeof(T);
+            header.data_offset = data_offset;
+            header.size.store(0, std::memory_order_relaxed);
+            header.capacity.store(initial_capacity, std::memory_order_release);
+            return result;
+        } catch (...) {
+            shm_unlink(name.c_str());
+            throw;
+        }
+    }
+
+    // Removes the name of a segment; processes that mapped it keep it until
+    // they unmap it.
+    static void remove(const std::string &name) {
+        if (shm_unlink(name.c_str()) != 0) {
+            detail::throw_errno("shm_unlink");
+        }
+    }
+
+    void push_back(const T &element) & {
+        std::size_t size = header().size.load(std::memory_order_relaxed);
+        std::size_t capacity =
+            header().capacity.load(std::memory_order_relaxed);
+        if (size == capacity) {
+            // `element` may be in the segment, which growing remaps.
+            T copy = element;
+            grow(capacity == 0 ? 1 : capacity * 2);
+            new (elements() + size) T(copy);
+        } else {
+            new (elements() + size) T(element);
+        }
+        header().size.store(size + 1, std::memory_order_release);
+    }
+
+    void reserve(std::size_t quantity) & {
+        if (quantity > header().capacity.load(std::memory_order_relaxed)) {
+            grow(quantity);
+        }
+    }
+
+    [[nodiscard]] T &operator[](std::size_t index) &noexcept {
+        return elements()[index];
+    }
+
+    [[nodiscard]] const T &operator[](std::size_t index) const &noexcept {
+        return elements()[index];
+    }
+
+    [[nodiscard]] T *data() noexcept {
+        return elements();
+    }
+
+    [[nodiscard]] const T *data() const noexcept {
+        return elements();
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return header().size.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept {
+        return header().capacity.load(std::memory_order_relaxed);
+    }
+};
+
+// Read-only attachment to a segment created by shm_vector. It sees the
+// elements that fit in its mapping; refresh() remaps it after the writer
+// grew the segment.
+template <typename T>
+class shm_reader {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    detail::shm_mapping mapping_;
+    const T *elements_ = nullptr;
+    std::size_t mapped_capacity_ = 0;
+
+    [[nodiscard]] const detail::shm_header &header() const noexcept {
+        return mapping_.header();
+    }
+
+    void update_view() noexcept {
+        std::size_t offset = header().data_offset;
+        elements_ = reinterpret_cast<const T *>(mapping_.bytes() + offset);
+        mapped_capacity_ = (mapping_.length() - offset) / sizeof(T);
+    }
+
+public:
+    using value_type = T;
+
+    explicit shm_reader(const std::string &name) {
+        int fd = detail::open_shm(name, O_RDONLY);
+        struct stat segment {};
+        if (fstat(fd, &segment) != 0) {
+            close(fd);
+            detail::throw_errno("fstat");
+        }
+        auto length = static_cast<std::size_t>(segment.st_size);
+        if (length < sizeof(detail::shm_header)) {
+            close(fd);
+            throw std::runtime_error("not a shared vector segment");
+        }
+        mapping_ = detail::shm_mapping(fd, length, false);
+        if (std::memcmp(header().magic, detail::shm_header::expected_magic,
+                        sizeof(header().magic)) != 0) {
+            throw std::runtime_error("not a shared vector segment");
+        }
+        if (header().element_size != sizeof(T)) {
+            throw std::runtime_error("shared vector has another element type");
+        }
+        // The elements must start after the header, aligned, in the segment.
+        std::size_t offset = header().data_offset;
+        if (offset < sizeof(detail::shm_header) || offset % alignof(T) != 0 ||
+            offset > length) {
+            throw std::runtime_error("shared vector header is corrupt");
+        }
+        update_view();
+    }
+
+    // Maps the part of the segment added since the last refresh. Returns
+    // whether the mapping changed, which invalidates references.
+    bool refresh() {
+        std::size_t capacity =
+            header().capacity.load(std::memory_order_acquire);
+        if (capacity <= mapped_capacity_) {
+            return false;
+        }
+        mapping_.remap(header().data_offset + capacity * sizeof(T));
+        update_view();
+        return true;
+    }
+
+    [[nodiscard]] const T &operator[](std::size_t index) const noexcept {
+        return elements_[index];
+    }
+
+    [[nodiscard]] const T &at(std::size_t index) const {
+        if (index >= size()) {
+            throw std::out_of_range("out of range");
+        }
+        return elements_[index];
+    }
+
+    [[nodiscard]] const T *data() const noexcept {
+        return elements_;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    // Number of published elements within the mapping.
+    [[nodiscard]] std::size_t size() const noexcept {
+        return std::min<std::size_t>(
+            header().size.load(std::memory_order_acquire), mapped_capacity_);
+    }
+};
+
+}  // namespace lab_07
+
+#endif  // SHM_VECTOR_H_
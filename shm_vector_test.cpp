@@ -0,0 +1,139 @@
+#include "shm_vector.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include "doctest.h"
+
+namespace {
+struct Sample {
+    std::uint64_t timestamp;
+    double value;
+};
+
+class SegmentName {
+    std::string name_ = "/lab07-test-" + std::to_string(getpid());
+
+public:
+    SegmentName() = default;
+    SegmentName(const SegmentName &) = delete;
+    SegmentName &operator=(const SegmentName &) = delete;
+    ~SegmentName() {
+        shm_unlink(name_.c_str());
+    }
+
+    [[nodiscard]] const std::string &get() const {
+        return name_;
+    }
+};
+}  // namespace
+
+TEST_CASE("shm_reader sees elements written through shm_vector") {
+    SegmentName name;
+    auto writer = lab_07::shm_vector<Sample>::create(name.get(), 4);
+    CHECK_THROWS_AS(lab_07::shm_vector<Sample>::create(name.get()),
+                    std::system_error);
+    writer.push_back(Sample{1, 0.5});
+
+    lab_07::shm_reader<Sample> reader(name.get());
+    REQUIRE(reader.size() == 1);
+    CHECK(reader[0].value == 0.5);
+    // Each side maps the segment at its own address.
+    CHECK(static_cast<const void *>(reader.data()) !=
+          static_cast<const void *>(writer.data()));
+
+    for (std::uint64_t i = 1; i < 10'000; i++) {
+        writer.push_back(Sample{i + 1, static_cast<double>(i)});
+    }
+    CHECK(writer.capacity() >= 10'000);
+    CHECK(reader.size() == 4);
+    CHECK(reader.refresh());
+    CHECK(!reader.refresh());
+    REQUIRE(reader.size() == 10'000);
+    CHECK(reader.at(9'999).timestamp == 10'000);
+    CHECK_THROWS_AS(static_cast<void>(reader.at(10'000)), std::out_of_range);
+
+    writer[0].value = 2.5;
+    CHECK(reader[0].value == 2.5);
+}
+
+TEST_CASE("shm_vector push_back of an own element survives remapping") {
+    SegmentName name;
+    auto writer = lab_07::shm_vector<Sample>::create(name.get());
+    writer.push_back(Sample{7, 1.5});
+    while (writer.size() < 5'000) {
+        writer.push_back(writer[0]);
+    }
+    for (std::size_t index = 0; index < writer.size(); index++) {
+        REQUIRE(writer[index].timestamp == 7);
+    }
+}
+
+TEST_CASE("shm_reader attaches from another process") {
+    SegmentName name;
+    auto writer = lab_07::shm_vector<std::int64_t>::create(name.get());
+    for (std::int64_t i = 0; i < 100'000; i++) {
+        writer.push_back(std::int64_t{i});
+    }
+    pid_t child = fork();
+    REQUIRE(child >= 0);
+    if (child == 0) {
+        int status = 1;
+        try {
+            lab_07::shm_reader<std::int64_t> reader(name.get());
+            std::int64_t sum = 0;
+            for (std::size_t i = 0; i < reader.size(); i++) {
+                sum += reader[i];
+            }
+            status = reader.size() == 100'000 &&
+                             sum == std::int64_t{99'999} * 100'000 / 2
+                         ? 0
+                         : 2;
+        } catch (...) {
+            status = 3;
+        }
+        _exit(status);
+    }
+    int status = 0;
+    REQUIRE(waitpid(child, &status, 0) == child);
+    CHECK(WIFEXITED(status));
+    CHECK(WEXITSTATUS(status) == 0);
+}
+
+TEST_CASE("shm_reader rejects segments of another element type") {
+    SegmentName name;
+    auto writer = lab_07::shm_vector<std::int32_t>::create(name.get());
+    CHECK_THROWS_AS(lab_07::shm_reader<std::int64_t>(name.get()),
+                    std::runtime_error);
+    CHECK_THROWS_AS(lab_07::shm_reader<std::int64_t>("/lab07-missing"),
+                    std::system_error);
+}
+
+TEST_CASE("shm_reader rejects a data offset outside the elements") {
+    SegmentName name;
+    auto writer = lab_07::shm_vector<std::int64_t>::create(name.get(), 4);
+    writer.push_back(7);
+    std::uint32_t offset = 0;
+    SUBCASE("inside the header") {
+        offset = 8;
+    }
+    SUBCASE("misaligned") {
+        offset = sizeof(lab_07::detail::shm_header) + 4;
+    }
+    SUBCASE("past the segment") {
+        offset = 1 << 20;
+    }
+    int fd = shm_open(name.get().c_str(), O_RDWR, 0);
+    REQUIRE(fd >= 0);
+    CHECK(pwrite(fd, &offset, sizeof(offset),
+                 offsetof(lab_07::detail::shm_header, data_offset)) ==
+          sizeof(offset));
+    close(fd);
+    CHECK_THROWS_WITH_AS(lab_07::shm_reader<std::int64_t>(name.get()),
+                         "shared vector header is corrupt",
+                         std::runtime_error);
+}
@@ -0,0 +1,283 @@
+#ifndef SLACK_H_
+#define SLACK_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#include "stats.h"
+
+namespace lab_07 {
+// One live vector in a slack_report.
+struct vector_slack {
+    std::string tag;
+    std::string type;
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+    // Unused capacity, (capacity - size) * sizeof(element).
+    std::size_t slack_bytes = 0;
+    std::size_t peak_capacity_bytes = 0;
+    // Time since the vector reached its peak capacity, or since it was
+    // created if it never allocated.
+    std::uint64_t peak_age_ns = 0;
+};
+
+struct slack_report {
+    std::size_t vectors = 0;
+    std::size_t capacity_bytes = 0;
+    std::size_t slack_bytes = 0;
+    // The vectors with the most slack, largest first.
+    std::vector<vector_slack> largest;
+};
+
+namespace detail {
+inline std::int64_t slack_clock_ns() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+template <typename Tag, typename = void>
+struct has_tag_name : std::false_type {};
+
+template <typename Tag>
+struct has_tag_name<Tag, std::void_t<decltype(Tag::name)>> : std::true_type {
+};
+
+// `Tag::name` if the tag has one, otherwise its type name.
+template <typename Tag>
+const char *tag_name() noexcept {
+    if constexpr (has_tag_name<Tag>::value) {
+        return Tag::name;
+    } else {
+        return typeid(Tag).name();
+    }
+}
+
+// Size and capacity of one live vector. Written only by the thread using
+// the vector, read by reports under the registry lock.
+struct slack_node {
+    const char *tag = nullptr;
+    const char *type = nullptr;
+    std::size_t element_size = 0;
+    std::atomic<std::size_t> size{0};
+    std::atomic<std::size_t> capacity{0};
+    std::atomic<std::size_t> peak_capacity{0};
+    std::atomic<std::int64_t> peak_time_ns{0};
+    // Guarded by the registry lock.
+    slack_node *prev = nullptr;
+    slack_node *next = nullptr;
+};
+
+// Spin lock that cannot fail, unlike std::mutex, so vectors register in
+// their noexcept constructors. Held only for a few pointer updates, or by a
+// report to copy the nodes into a buffer reserved beforehand.
+class slack_lock {
+    std::atomic_flag locked_ = ATOMIC_FLAG_INIT;
+
+public:
+    void lock() noexcept {
+        while (locked_.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock() noexcept {
+        locked_.clear(std::memory_order_release);
+    }
+};
+
+// Intrusive list of the nodes of all live tracked vectors. Only creating
+// and destroying a vector and taking a report take the lock.
+class slack_registry {
+    // The fields of a node, copied under the lock.
+    struct sample {
+        const char *tag;
+        const char *type;
+        std::size_t element_size;
+        std::size_t size;
+        std::size_t capacity;
+        std::size_t peak_capacity;
+        std::int64_t peak_time_ns;
+
+        [[nodiscard]] std::size_t slack_bytes() const noexcept {
+            // Loaded separately, so a concurrent push may be seen as a size
+            // above the capacity.
+            return capacity > size ? (capacity - size) * element_size : 0;
+        }
+    };
+
+    slack_lock lock_;
+    slack_node *head_ = nullptr;
+    // Written under the lock, read before taking it to size the buffer.
+    std::atomic<std::size_t> nodes_{0};
+
+    // Copies every node into `samples` if its capacity suffices.
+    bool try_sample(std::vector<sample> &samples) noexcept {
+        std::lock_guard lock(lock_);
+        if (nodes_.load(std::memory_order_relaxed) > samples.capacity()) {
+            return false;
+        }
+        for (slack_node *node = head_; node != nullptr; node = node->next) {
+            samples.push_back(sample{
+                node->tag, node->type, node->element_size,
+                node->size.load(std::memory_order_relaxed),
+                node->capacity.load(std::memory_order_relaxed),
+                node->peak_capacity.load(std::memory_order_relaxed),
+                node->peak_time_ns.load(std::memory_order_relaxed)});
+        }
+        return true;
+    }
+
+public:
+    static slack_registry &instance() {
+        static slack_registry registry;
+        return registry;
+    }
+
+    void attach(slack_node *node) noexcept {
+        std::lock_guard lock(lock_);
+        node->next = head_;
+        if (head_ != nullptr) {
+            head_->prev = node;
+        }
+        head_ = node;
+        nodes_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void detach(slack_node *node) noexcept {
+        std::lock_guard lock(lock_);
+        if (node->prev != nullptr) {
+            node->prev->next = node->next;
+        } else {
+            head_ = node->next;
+        }
+        if (node->next != nullptr) {
+            node->next->prev = node->prev;
+        }
+        nodes_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Allocates and formats only while the lock is not held, so vectors
+    // being created and destroyed wait for no more than a copy of the list.
+    slack_report report(std::size_t largest) {
+        std::vector<sample> samples;
+        do {
+            samples.reserve(nodes_.load(std::memory_order_relaxed) + 16);
+        } while (!try_sample(samples));
+        std::int64_t now = slack_clock_ns();
+
+        slack_report result;
+        result.vectors = samples.size();
+        for (const sample &node : samples) {
+            result.capacity_bytes += node.capacity * node.element_size;
+            result.slack_bytes += node.slack_bytes();
+        }
+        auto more_slack = [](const sample &lhs, const sample &rhs) {
+            return lhs.slack_bytes() > rhs.slack_bytes();
+        };
+        std::size_t kept = std::min(largest, samples.size());
+        std::partial_sort(samples.begin(), samples.begin() + kept,
+                          samples.end(), more_slack);
+        result.largest.reserve(kept);
+        for (std::size_t index = 0; index < kept; index++) {
+            const sample &node = samples[index];
+            vector_slack entry;
+            entry.tag = node.tag;
+            entry.type = node.type;
+            entry.size = node.size;
+            entry.capacity = node.capacity;
+            entry.slack_bytes = node.slack_bytes();
+            entry.peak_capacity_bytes = node.peak_capacity * node.element_size;
+            entry.peak_age_ns = static_cast<std::uint64_t>(
+                std::max<std::int64_t>(now - node.peak_time_ns, 0));
+            result.largest.push_back(std::move(entry));
+        }
+        return result;
+    }
+};
+
+// Registers the vector deriving from it while the vector lives.
+template <typename T, typename Policy>
+class slack_tracking<T, Policy, true> {
+    slack_node node_;
+
+protected:
+    slack_tracking() noexcept {
+        node_.tag = tag_name<typename Policy::tag>();
+        node_.type = typeid(T).name();
+        node_.element_size = sizeof(T);
+        node_.peak_time_ns.store(slack_clock_ns(), std::memory_order_relaxed);
+        slack_registry::instance().attach(&node_);
+    }
+
+    slack_tracking(const slack_tracking &) = delete;
+    slack_tracking &operator=(const slack_tracking &) = delete;
+
+    ~slack_tracking() {
+        slack_registry::instance().detach(&node_);
+    }
+
+    void slack_changed(std::size_t size, std::size_t capacity) noexcept {
+        node_.size.store(size, std::memory_order_relaxed);
+        node_.capacity.store(capacity, std::memory_order_relaxed);
+        if (capacity > node_.peak_capacity.load(std::memory_order_relaxed)) {
+            node_.peak_capacity.store(capacity, std::memory_order_relaxed);
+            node_.peak_time_ns.store(slack_clock_ns(),
+                                     std::memory_order_relaxed);
+        }
+    }
+};
+}  // namespace detail
+
+namespace stats_policy {
+// per_tag<Tag> counters, plus a registry of the live vectors using the
+// policy: see live_vector_slack(). Every vector holds a registry node and
+// publishes its size and capacity with relaxed stores on each change.
+// `Tag::name`, if declared, labels the vectors in reports; the tag is part
+// of the vector type, so each call site to tell apart needs its own tag.
+template <typename Tag>
+struct slack_per_tag : per_tag<Tag> {
+    using tag = Tag;
+    static constexpr bool tracks_slack = true;
+};
+}  // namespace stats_policy
+
+// Totals over all live vectors using a slack_per_tag policy, and the
+// `largest` vectors with the most unused capacity.
+inline slack_report live_vector_slack(std::size_t largest = 10) {
+    return detail::slack_registry::instance().report(largest);
+}
+
+// Writes live_vector_slack(largest) to `out` as JSON lines: the totals,
+// then one line per vector.
+inline void dump_slack_report(std::FILE *out, std::size_t largest = 10) {
+    slack_report report = live_vector_slack(largest);
+    std::fprintf(out,
+                 "{\"vectors\": %zu, \"capacity_bytes\": %zu, "
+                 "\"slack_bytes\": %zu}\n",
+                 report.vectors, report.capacity_bytes, report.slack_bytes);
+    for (const vector_slack &entry : report.largest) {
+        std::fprintf(
+            out,
+            "{\"tag\": \"%s\", \"type\": \"%s\", \"size\": %zu, "
+            "\"capacity\": %zu, \"slack_bytes\": %zu, "
+            "\"peak_capacity_bytes\": %zu, \"peak_age_ns\": %llu}\n",
+            entry.tag.c_str(), entry.type.c_str(), entry.size, entry.capacity,
+            entry.slack_bytes, entry.peak_capacity_bytes,
+            static_cast<unsigned long long>(entry.peak_age_ns));
+    }
+}
+
+}  // namespace lab_07
+
+#endif  // SLACK_H_
@@ -0,0 +1,96 @@
+#include "slack.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include "doctest.h"
+#include "vector.h"
+
+namespace {
+struct cache_tag {
+    static constexpr const char *name = "cache";
+};
+
+struct queue_tag {};
+
+template <typename T, typename Tag>
+using profiled_vector =
+    lab_07::vector<T,
+                   std::allocator<T>,
+                   lab_07::exception_policy::strong,
+                   lab_07::stats_policy::slack_per_tag<Tag>>;
+
+lab_07::slack_report report_for(const std::string &tag) {
+    lab_07::slack_report full = lab_07::live_vector_slack(1'000);
+    lab_07::slack_report result;
+    for (const lab_07::vector_slack &entry : full.largest) {
+        if (entry.tag == tag) {
+            result.vectors++;
+            result.capacity_bytes += entry.capacity * sizeof(int);
+            result.slack_bytes += entry.slack_bytes;
+            result.largest.push_back(entry);
+        }
+    }
+    return result;
+}
+}  // namespace
+
+TEST_CASE("live_vector_slack tracks live vectors by tag") {
+    CHECK(report_for("cache").vectors == 0);
+    {
+        profiled_vector<int, cache_tag> small;
+        profiled_vector<int, cache_tag> large;
+        for (int value = 0; value < 5; value++) {
+            small.push_back(int{value});
+        }
+        large.reserve(100);
+        large.push_back(1);
+
+        lab_07::slack_report report = report_for("cache");
+        CHECK(report.vectors == 2);
+        CHECK(report.capacity_bytes == (8 + 128) * sizeof(int));
+        CHECK(report.slack_bytes == (3 + 127) * sizeof(int));
+        REQUIRE(report.largest.size() == 2);
+        CHECK(report.largest[0].capacity == 128);
+        CHECK(report.largest[0].size == 1);
+        CHECK(report.largest[1].slack_bytes == 3 * sizeof(int));
+
+        profiled_vector<int, cache_tag> moved(std::move(large));
+        report = report_for("cache");
+        CHECK(report.vectors == 3);
+        CHECK(report.slack_bytes == (3 + 127) * sizeof(int));
+
+        small.resize(8);
+        small.clear();
+        report = report_for("cache");
+        CHECK(report.slack_bytes == (8 + 127) * sizeof(int));
+    }
+    CHECK(report_for("cache").vectors == 0);
+}
+
+TEST_CASE("live_vector_slack keeps the peak capacity and its age") {
+    profiled_vector<int, queue_tag> v(10);
+    v.resize(2);
+    {
+        auto buffer = v.release();
+    }
+    lab_07::slack_report report = lab_07::live_vector_slack(1'000);
+    bool found = false;
+    for (const lab_07::vector_slack &entry : report.largest) {
+        if (entry.tag == typeid(queue_tag).name()) {
+            found = true;
+            CHECK(entry.capacity == 0);
+            CHECK(entry.slack_bytes == 0);
+            CHECK(entry.peak_capacity_bytes == 16 * sizeof(int));
+        }
+    }
+    CHECK(found);
+    CHECK(lab_07::live_vector_slack(0).largest.empty());
+
+    std::FILE *out = std::tmpfile();
+    REQUIRE(out != nullptr);
+    lab_07::dump_slack_report(out, 1);
+    CHECK(std::ftell(out) > 0);
+    std::fclose(out);
+}
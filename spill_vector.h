@@ -0,0 +1,378 @@
+#ifndef SPILL_VECTOR_H_
+#define SPILL_VECTOR_H_
+
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "serialize.h"
+
+namespace lab_07 {
+struct spill_stats {
+    std::size_t spills = 0;
+    std::size_t loads = 0;
+    std::size_t prefetched_loads = 0;
+};
+
+// Vector of trivially copyable elements kept in fixed-size chunks, of which
+// only as many as fit in the memory budget stay resident. The least
+// recently used chunks are spilled to an unlinked temporary file and read
+// back on access; while chunks are visited in order, the next one is read
+// ahead on a background thread.
+//
+// Element access on a non-const vector returns a spill_vector::reference,
+// so that reading an element leaves its chunk clean and only chunks that
+// were assigned to are written back. A const T & returned by a const access
+// stays valid until the next access to another element. Not safe for
+// concurrent use.
+template <typename T>
+class spill_vector {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+    struct free_buffer {
+        void operator()(T *data) const noexcept {
+            ::operator delete(data);
+        }
+    };
+
+    using buffer = std::unique_ptr<T, free_buffer>;
+
+    struct chunk {
+        // Null while the chunk is spilled.
+        buffer data;
+        bool dirty = false;
+        bool on_disk = false;
+        std::list<std::size_t>::iterator lru;
+    };
+
+    enum class prefetch_state { idle, requested, ready, failed };
+
+    int fd_ = -1;
+    std::size_t chunk_size_;
+    std::size_t max_resident_;
+    std::size_t size_ = 0;
+    // Residency is not part of the observable state, so const accesses
+    // update it too.
+    mutable std::vector<chunk> chunks_;
+    // Resident chunks, most recently used first.
+    mutable std::list<std::size_t> lru_;
+    mutable std::size_t last_chunk_ = 0;
+    mutable spill_stats stats_;
+
+    // Read-ahead of one chunk into prefetch_buffer_, guarded by mutex_.
+    // While no read is in flight, the buffer is also a spare for chunks
+    // becoming resident.
+    std::thread worker_;
+    mutable std::mutex mutex_;
+    mutable std::condition_variable wake_;
+    mutable std::condition_variable done_;
+    mutable buffer prefetch_buffer_;
+    mutable std::size_t prefetch_chunk_ = 0;
+    mutable std::size_t prefetch_bytes_ = 0;
+    mutable prefetch_state prefetch_ = prefetch_state::idle;
+    bool stop_ = false;
+
+    [[nodiscard]] std::size_t chunk_bytes() const noexcept {
+        return chunk_size_ * sizeof(T);
+    }
+
+    [[nodiscard]] std::size_t elements_in(std::size_t index) const noexcept {
+        return std::min(chunk_size_, size_ - index * chunk_size_);
+    }
+
+    buffer new_buffer() const {
+        return buffer(static_cast<T *>(::operator new(chunk_bytes())));
+    }
+
+    // Reuses the read-ahead buffer unless a read into it is in flight.
+    buffer allocate_buffer() const {
+        {
+            std::lock_guard lock(mutex_);
+            if (prefetch_ != prefetch_state::requested && prefetch_buffer_) {
+                prefetch_ = prefetch_state::idle;
+                return std::move(prefetch_buffer_);
+            }
+        }
+        return new_buffer();
+    }
+
+    void free_or_keep(buffer data) const noexcept {
+        std::lock_guard lock(mutex_);
+        if (!prefetch_buffer_) {
+            prefetch_buffer_ = std::move(data);
+        }
+    }
+
+    void read_chunk(std::size_t index, T *data) const {
+        detail::pread_all(fd_, data, elements_in(index) * sizeof(T),
+                          index * chunk_bytes());
+    }
+
+    void evict() const {
+        std::size_t index = lru_.back();
+        chunk &victim = chunks_[index];
+        if (victim.dirty) {
+            detail::pwrite_all(fd_, victim.data.get(),
+                               elements_in(index) * sizeof(T),
+                               index * chunk_bytes());
+            victim.dirty = false;
+            victim.on_disk = true;
+            stats_.spills++;
+        }
+        lru_.pop_back();
+        free_or_keep(std::move(victim.data));
+    }
+
+    // Evicts chunks until one more fits in the budget.
+    void make_room() const {
+        while (lru_.size() >= max_resident_) {
+            evict();
+        }
+    }
+
+    void make_resident(std::size_t index, buffer data) const {
+        chunk &target = chunks_[index];
+        target.data = std::move(data);
+        lru_.push_front(index);
+        target.lru = lru_.begin();
+    }
+
+    void prefetch_loop() {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] {
+                return stop_ || prefetch_ == prefetch_state::requested;
+            });
+            if (stop_) {
+                return;
+            }
+            std::size_t offset = prefetch_chunk_ * chunk_bytes();
+            std::size_t bytes = prefetch_bytes_;
+            T *data = prefetch_buffer_.get();
+            lock.unlock();
+            bool succeeded = true;
+            try {
+                detail::pread_all(fd_, data, bytes, offset);
+            } catch (...) {
+                succeeded = false;
+            }
+            lock.lock();
+            prefetch_ =
+                succeeded ? prefetch_state::ready : prefetch_state::failed;
+            done_.notify_all();
+        }
+    }
+
+    void request_prefetch(std::size_t index) const {
+        if (index >= chunks_.size() || chunks_[index].data ||
+            !chunks_[index].on_disk) {
+            return;
+        }
+        std::lock_guard lock(mutex_);
+        if (prefetch_ == prefetch_state::requested ||
+            (prefetch_ == prefetch_state::ready && prefetch_chunk_ == index)) {
+            return;
+        }
+        if (!prefetch_buffer_) {
+            prefetch_buffer_ = new_buffer();
+        }
+        prefetch_chunk_ = index;
+        prefetch_bytes_ = elements_in(index) * sizeof(T);
+        prefetch_ = prefetch_state::requested;
+        wake_.notify_one();
+    }
+
+    // Takes the read-ahead buffer if it holds chunk `index`.
+    buffer take_prefetched(std::size_t index) const {
+        std::unique_lock lock(mutex_);
+        if (prefetch_ == prefetch_state::idle || prefetch_chunk_ != index ||
+            !prefetch_buffer_) {
+            return nullptr;
+        }
+        done_.wait(lock,
+                   [&] { return prefetch_ != prefetch_state::requested; });
+        bool ready = prefetch_ == prefetch_state::ready;
+        prefetch_ = prefetch_state::idle;
+        return ready ? std::move(prefetch_buffer_) : nullptr;
+    }
+
+    T *acquire(std::size_t index) const {
+        chunk &target = chunks_[index];
+        if (target.data) {
+            lru_.splice(lru_.begin(), lru_, target.lru);
+        } else {
+            make_room();
+            buffer data = take_prefetched(index);
+            if (data) {
+                stats_.prefetched_loads++;
+            } else {
+                data = allocate_buffer();
+                read_chunk(index, data.get());
+                stats_.loads++;
+            }
+            make_resident(index, std::move(data));
+        }
+        if (index != last_chunk_) {
+            bool sequential = index == last_chunk_ + 1;
+            last_chunk_ = index;
+            if (sequential) {
+                request_prefetch(index + 1);
+            }
+        }
+        return target.data.get();
+    }
+
+public:
+    using value_type = T;
+
+    // Proxy for an element of a non-const spill_vector: converts to T by
+    // reading the element, and marks its chunk modified only on assignment.
+    class reference {
+        spill_vector *vector_;
+        std::size_t index_;
+
+        friend class spill_vector;
+
+        reference(spill_vector &vector, std::size_t index) noexcept
+            : vector_(&vector), index_(index) {
+        }
+
+    public:
+        reference(const reference &) noexcept = default;
+
+        // NOLINTNEXTLINE(google-explicit-constructor)
+        operator T() const {
+            return std::as_const(*vector_)[index_];
+        }
+
+        // NOLINTNEXTLINE(cppcoreguidelines-c-copy-assignment-signature)
+        reference &operator=(const T &value) {
+            std::size_t chunk_index = index_ / vector_->chunk_size_;
+            T *data = vector_->acquire(chunk_index);
+            data[index_ % vector_->chunk_size_] = value;
+            vector_->chunks_[chunk_index].dirty = true;
+            return *this;
+        }
+
+        // Assigns the value, not the reference.
+        // NOLINTNEXTLINE(bugprone-unhandled-self-assignment)
+        reference &operator=(const reference &other) {
+            return *this = static_cast<T>(other);
+        }
+    };
+
+    // Keeps at most `memory_budget` bytes of elements in memory, including
+    // the read-ahead buffer, in chunks of about `chunk_bytes` bytes. The
+    // temporary file is created in `directory`.
+    explicit spill_vector(std::size_t memory_budget,
+                          std::size_t chunk_bytes = std::size_t{1} << 20,
+                          const std::string &directory = "/tmp")
+        : chunk_size_(std::max<std::size_t>(1, chunk_bytes / sizeof(T))),
+          max_resident_(memory_budget / (chunk_size_ * sizeof(T))) {
+        if (max_resident_ < 2) {
+            throw std::invalid_argument(
+                "spill_vector budget must hold at least two chunks");
+        }
+        // One chunk of the budget is the read-ahead buffer.
+        max_resident_--;
+        fd_ = detail::open_temporary_file(directory);
+        try {
+            worker_ = std::thread([this] { prefetch_loop(); });
+        } catch (...) {
+            close(fd_);
+            throw;
+        }
+    }
+
+    spill_vector(const spill_vector &) = delete;
+    spill_vector &operator=(const spill_vector &) = delete;
+
+    ~spill_vector() noexcept {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        worker_.join();
+        close(fd_);
+    }
+
+    // Offers the strong guarantee: a failed spill leaves the vector
+    // unchanged.
+    void push_back(const T &element) & {
+        if (size_ % chunk_size_ == 0) {
+            chunks_.emplace_back();
+            try {
+                make_room();
+                make_resident(chunks_.size() - 1, allocate_buffer());
+            } catch (...) {
+                chunks_.pop_back();
+                throw;
+            }
+        }
+        std::size_t index = size_ / chunk_size_;
+        T *data = acquire(index);
+        new (data + size_ % chunk_size_) T(element);
+        chunks_[index].dirty = true;
+        size_++;
+    }
+
+    [[nodiscard]] reference operator[](std::size_t index) & {
+        return reference(*this, index);
+    }
+
+    [[nodiscard]] const T &operator[](std::size_t index) const & {
+        return acquire(index / chunk_size_)[index % chunk_size_];
+    }
+
+    [[nodiscard]] reference at(std::size_t index) & {
+        if (index >= size_) {
+            throw std::out_of_range("out of range");
+        }
+        return (*this)[index];
+    }
+
+    [[nodiscard]] const T &at(std::size_t index) const & {
+        if (index >= size_) {
+            throw std::out_of_range("out of range");
+        }
+        return (*this)[index];
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return size_;
+    }
+
+    // Number of elements per chunk.
+    [[nodiscard]] std::size_t chunk_size() const noexcept {
+        return chunk_size_;
+    }
+
+    [[nodiscard]] std::size_t resident_chunks() const noexcept {
+        return lru_.size();
+    }
+
+    [[nodiscard]] spill_stats statistics() const noexcept {
+        return stats_;
+    }
+};
+
+}  // namespace lab_07
+
+#endif  // SPILL_VECTOR_H_
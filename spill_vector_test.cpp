@@ -0,0 +1,66 @@
+#include "spill_vector.h"
+#include <cstdint>
+#include <stdexcept>
+#include "doctest.h"
+
+TEST_CASE("spill_vector keeps elements beyond its memory budget") {
+    // Chunks of 512 elements, three resident plus the read-ahead buffer.
+    lab_07::spill_vector<std::uint64_t> v(4 * 4096, 4096);
+    REQUIRE(v.chunk_size() == 512);
+    for (std::uint64_t i = 0; i < 10'000; i++) {
+        v.push_back(i * 3);
+        CHECK(v.resident_chunks() <= 3);
+    }
+    CHECK(v.size() == 10'000);
+    CHECK(v.statistics().spills > 0);
+
+    SUBCASE("sequential scans read ahead") {
+        for (int pass = 0; pass < 2; pass++) {
+            std::uint64_t sum = 0;
+            const auto &view = v;
+            for (std::size_t i = 0; i < view.size(); i++) {
+                sum += view[i];
+            }
+            CHECK(sum == std::uint64_t{9'999} * 10'000 / 2 * 3);
+        }
+        CHECK(v.statistics().prefetched_loads > 0);
+        CHECK(v.resident_chunks() <= 3);
+    }
+
+    SUBCASE("modified chunks are written back") {
+        for (std::size_t i = 0; i < v.size(); i += 97) {
+            v[i] = 1;
+        }
+        for (std::size_t i = v.size(); i-- > 0;) {
+            CHECK(v[i] == (i % 97 == 0 ? 1 : i * 3));
+        }
+        CHECK(v.at(9'999) == 9'999 * 3);
+        CHECK_THROWS_AS(static_cast<void>(v.at(10'000)), std::out_of_range);
+        v[0] = v[1];
+        CHECK(v[0] == 3);
+    }
+
+    SUBCASE("reading through a non-const vector writes nothing back") {
+        // The first scan writes back the chunks still dirty from pushing.
+        std::size_t spills = v.statistics().spills;
+        for (int pass = 0; pass < 2; pass++) {
+            std::uint64_t sum = 0;
+            for (std::size_t i = 0; i < v.size(); i++) {
+                sum += v[i];
+            }
+            CHECK(sum == std::uint64_t{9'999} * 10'000 / 2 * 3);
+        }
+        CHECK(v.statistics().spills <= spills + 3);
+        spills = v.statistics().spills;
+        for (std::size_t i = 0; i < v.size(); i++) {
+            std::uint64_t value = v.at(i);
+            REQUIRE(value == i * 3);
+        }
+        CHECK(v.statistics().spills == spills);
+    }
+}
+
+TEST_CASE("spill_vector needs room for two chunks") {
+    CHECK_THROWS_AS(lab_07::spill_vector<int>(4096, 4096),
+                    std::invalid_argument);
+}
@@ -0,0 +1,163 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace lab_07 {
+// Operations of the vectors sharing a statistics policy, see stats_policy.
+struct vector_stats {
+    // Buffers obtained from the allocator, including reallocations.
+    std::size_t allocations = 0;
+    // Growths of a non-empty buffer.
+    std::size_t reallocations = 0;
+    // Elements moved to a new buffer by reallocations.
+    std::size_t elements_relocated = 0;
+    // Bytes of elements created by copying another element.
+    std::size_t bytes_copied = 0;
+    // Largest capacity of any of the vectors, in bytes.
+    std::size_t peak_capacity_bytes = 0;
+    // Operations undone because an element constructor threw.
+    std::size_t rollbacks = 0;
+};
+
+// Phases of growing a vector, timed by policies such as
+// stats_policy::timed_per_type.
+enum class growth_phase { allocate, relocate, deallocate };
+
+namespace detail {
+// Whether the policy times growth phases through
+// `Policy::growth_timed<T>(phase, capacity_bytes, nanoseconds)`.
+template <typename Policy, typename = void>
+struct times_growth : std::false_type {};
+
+template <typename Policy>
+struct times_growth<Policy, std::enable_if_t<Policy::times_growth>>
+    : std::true_type {};
+
+// Whether the policy tracks the capacity slack of live vectors, in which
+// case vectors derive from the slack_tracking specialization in slack.h.
+template <typename Policy, typename = void>
+struct tracks_slack : std::false_type {};
+
+template <typename Policy>
+struct tracks_slack<Policy, std::enable_if_t<Policy::tracks_slack>>
+    : std::true_type {};
+
+template <typename T,
+          typename Policy,
+          bool = tracks_slack<Policy>::value>
+class slack_tracking {};
+
+class stats_counters {
+    std::atomic<std::size_t> allocations_{0};
+    std::atomic<std::size_t> reallocations_{0};
+    std::atomic<std::size_t> elements_relocated_{0};
+    std::atomic<std::size_t> bytes_copied_{0};
+    std::atomic<std::size_t> peak_capacity_bytes_{0};
+    std::atomic<std::size_t> rollbacks_{0};
+
+    void update_peak(std::size_t capacity_bytes) noexcept {
+        std::size_t peak = peak_capacity_bytes_.load(std::memory_order_relaxed);
+        while (peak < capacity_bytes &&
+               !peak_capacity_bytes_.compare_exchange_weak(
+                   peak, capacity_bytes, std::memory_order_relaxed)) {
+        }
+    }
+
+public:
+    void allocated(std::size_t capacity_bytes) noexcept {
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        update_peak(capacity_bytes);
+    }
+
+    void reallocated(std::size_t relocated,
+                     std::size_t capacity_bytes) noexcept {
+        reallocations_.fetch_add(1, std::memory_order_relaxed);
+        elements_relocated_.fetch_add(relocated, std::memory_order_relaxed);
+        update_peak(capacity_bytes);
+    }
+
+    void copied(std::size_t bytes) noexcept {
+        bytes_copied_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void rolled_back() noexcept {
+        rollbacks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] vector_stats snapshot() const noexcept {
+        vector_stats result;
+        result.allocations = allocations_.load(std::memory_order_relaxed);
+        result.reallocations = reallocations_.load(std::memory_order_relaxed);
+        result.elements_relocated =
+            elements_relocated_.load(std::memory_order_relaxed);
+        result.bytes_copied = bytes_copied_.load(std::memory_order_relaxed);
+        result.peak_capacity_bytes =
+            peak_capacity_bytes_.load(std::memory_order_relaxed);
+        result.rollbacks = rollbacks_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void reset() noexcept {
+        allocations_.store(0, std::memory_order_relaxed);
+        reallocations_.store(0, std::memory_order_relaxed);
+        elements_relocated_.store(0, std::memory_order_relaxed);
+        bytes_copied_.store(0, std::memory_order_relaxed);
+        peak_capacity_bytes_.store(0, std::memory_order_relaxed);
+        rollbacks_.store(0, std::memory_order_relaxed);
+    }
+};
+
+template <typename Policy, typename Key>
+inline stats_counters stats_storage;
+}  // namespace detail
+
+// Where a vector records its operations. The counters are relaxed atomics
+// shared by all vectors with the same key, so snapshots taken while other
+// threads use the vectors are approximate.
+namespace stats_policy {
+// Records nothing, at no cost.
+struct none {};
+
+// One set of counters per element type.
+struct per_type {
+    template <typename T>
+    [[nodiscard]] static detail::stats_counters &counters() noexcept {
+        return detail::stats_storage<per_type, T>;
+    }
+
+    template <typename T>
+    [[nodiscard]] static vector_stats snapshot() noexcept {
+        return counters<T>().snapshot();
+    }
+
+    template <typename T>
+    static void reset() noexcept {
+        counters<T>().reset();
+    }
+};
+
+// One set of counters for every vector using per_tag<Tag>, whatever its
+// element type.
+template <typename Tag>
+struct per_tag {
+    template <typename T>
+    [[nodiscard]] static detail::stats_counters &counters() noexcept {
+        return detail::stats_storage<per_tag, void>;
+    }
+
+    [[nodiscard]] static vector_stats snapshot() noexcept {
+        return counters<void>().snapshot();
+    }
+
+    static void reset() noexcept {
+        counters<void>().reset();
+    }
+};
+}  // namespace stats_policy
+
+}  // namespace lab_07
+
+#endif  // STATS_H_
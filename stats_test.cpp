@@ -0,0 +1,86 @@
+#include "stats.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include "doctest.h"
+#include "vector.h"
+
+namespace {
+template <typename T>
+using per_type_vector = lab_07::vector<T,
+                                       std::allocator<T>,
+                                       lab_07::exception_policy::strong,
+                                       lab_07::stats_policy::per_type>;
+
+struct parser_tag {};
+
+template <typename T>
+using parser_vector = lab_07::vector<T,
+                                     std::allocator<T>,
+                                     lab_07::exception_policy::strong,
+                                     lab_07::stats_policy::per_tag<parser_tag>>;
+
+struct artificial_exception {};
+
+struct throwing_copy {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    bool can_copy = true;
+
+    throwing_copy() = default;
+
+    throwing_copy(const throwing_copy &other) : can_copy(other.can_copy) {
+        if (!can_copy) {
+            throw artificial_exception();
+        }
+    }
+
+    throwing_copy(throwing_copy &&) noexcept = default;
+    throwing_copy &operator=(const throwing_copy &) = default;
+    throwing_copy &operator=(throwing_copy &&) noexcept = default;
+    ~throwing_copy() = default;
+};
+}  // namespace
+
+TEST_CASE("per_type statistics count growth and copies") {
+    lab_07::stats_policy::per_type::reset<int>();
+    {
+        per_type_vector<int> v;
+        for (int value = 0; value < 5; value++) {
+            v.push_back(int{value});
+        }
+        per_type_vector<int> copy(v);
+        copy.resize(10, 7);
+    }
+    lab_07::vector_stats stats =
+        lab_07::stats_policy::per_type::snapshot<int>();
+    // 1, 2, 4 and 8 elements for v, 8 then 16 for the copy.
+    CHECK(stats.allocations == 6);
+    CHECK(stats.reallocations == 4);
+    CHECK(stats.elements_relocated == 1 + 2 + 4 + 5);
+    CHECK(stats.bytes_copied == (5 + 5) * sizeof(int));
+    CHECK(stats.peak_capacity_bytes == 16 * sizeof(int));
+    CHECK(stats.rollbacks == 0);
+
+    CHECK(lab_07::stats_policy::per_type::snapshot<long>().allocations == 0);
+}
+
+TEST_CASE("per_tag statistics aggregate element types and rollbacks") {
+    lab_07::stats_policy::per_tag<parser_tag>::reset();
+    parser_vector<std::string> strings(2);
+    parser_vector<throwing_copy> objects(2);
+    throwing_copy broken;
+    broken.can_copy = false;
+    CHECK_THROWS_AS(objects.push_back(broken), artificial_exception);
+    CHECK_THROWS_AS(objects.resize(3, broken), artificial_exception);
+    REQUIRE(objects.size() == 2);
+
+    lab_07::vector_stats stats =
+        lab_07::stats_policy::per_tag<parser_tag>::snapshot();
+    // Both failed pushes allocated a staging buffer of 4 elements.
+    CHECK(stats.allocations == 4);
+    CHECK(stats.reallocations == 0);
+    CHECK(stats.rollbacks == 2);
+    CHECK(stats.bytes_copied == 0);
+    CHECK(stats.peak_capacity_bytes ==
+          std::max(4 * sizeof(throwing_copy), 2 * sizeof(std::string)));
+}
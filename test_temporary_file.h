@@ -0,0 +1,38 @@
+#ifndef TEST_TEMPORARY_FILE_H_
+#define TEST_TEMPORARY_FILE_H_
+
+#include <unistd.h>
+#include <cstdlib>
+#include <string>
+#include "doctest.h"
+
+// Scratch file for tests, removed on destruction.
+class TemporaryFile {
+    std::string path_ = "/tmp/lab07-test-XXXXXX";
+    int fd_ = mkstemp(path_.data());
+
+public:
+    TemporaryFile() {
+        REQUIRE(fd_ >= 0);
+    }
+    TemporaryFile(const TemporaryFile &) = delete;
+    TemporaryFile &operator=(const TemporaryFile &) = delete;
+    ~TemporaryFile() {
+        close(fd_);
+        unlink(path_.c_str());
+    }
+
+    [[nodiscard]] int fd() const {
+        return fd_;
+    }
+
+    [[nodiscard]] const char *path() const {
+        return path_.c_str();
+    }
+
+    void rewind() const {
+        REQUIRE(lseek(fd_, 0, SEEK_SET) == 0);
+    }
+};
+
+#endif  // TEST_TEMPORARY_FILE_H_
@@ -0,0 +1,22 @@
+#ifndef USDT_STUB_SYS_SDT_H_
+#define USDT_STUB_SYS_SDT_H_
+
+// Stand-in for systemtap's <sys/sdt.h> that counts the probes fired instead
+// of emitting them, so vector_probes_tu.cpp builds and checks the enabled
+// probe sites without systemtap installed.
+struct usdt_stub_counts {
+    int grow = 0;
+    int resize_grow = 0;
+    int reserve = 0;
+    int shrink = 0;
+    int rollback = 0;
+};
+
+inline usdt_stub_counts usdt_stub_fired;
+
+#define DTRACE_PROBE4(provider, name, arg1, arg2, arg3, arg4)               \
+    (static_cast<void>(arg1), static_cast<void>(arg2),                      \
+     static_cast<void>(arg3), static_cast<void>(arg4),                      \
+     static_cast<void>(usdt_stub_fired.name++))
+
+#endif  // USDT_STUB_SYS_SDT_H_
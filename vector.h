@@ -3,16 +3,32 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <stdexcept>
 #include <type_traits>
 #include <utility>
+#include "exceptions.h"
+#include "parallel.h"
+#include "probes.h"
+#include "stats.h"
 
 namespace lab_07 {
+// The smallest power of two not below `n`, or `n` itself when no power of
+// two that large fits in std::size_t.
 inline std::size_t calculate_capacity(std::size_t n) {
     if (n == 0) {
         return 0;
     }
+    if (n > std::numeric_limits<std::size_t>::max() / 2 + 1) {
+        return n;
+    }
     std::size_t power_of_two = 1;
     while (power_of_two < n) {
         power_of_two *= 2;
@@ -20,42 +36,464 @@ inline std::size_t calculate_capacity(std::size_t n) {
     return power_of_two;
 }
 
+// Types whose objects may be moved by copying their bytes and forgetting the
+// source. Specialize for types that are not trivially copyable but are safe
+// to relocate this way.
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+namespace detail {
+template <typename Alloc, typename = void>
+struct has_reallocate : std::false_type {};
+
+template <typename Alloc>
+struct has_reallocate<
+    Alloc,
+    std::void_t<decltype(std::declval<Alloc &>().reallocate(
+        std::declval<typename Alloc::value_type *>(),
+        std::size_t{},
+        std::size_t{}))>> : std::true_type {};
+
+template <typename Alloc, typename = void>
+struct has_try_allocate : std::false_type {};
+
+template <typename Alloc>
+struct has_try_allocate<
+    Alloc,
+    std::void_t<decltype(std::declval<Alloc &>().try_allocate(
+        std::size_t{}))>> : std::true_type {};
+
+// Holds an allocator, taking no space when it is an empty class.
+template <typename Alloc,
+          bool = std::is_empty_v<Alloc> && !std::is_final_v<Alloc>>
+class allocator_holder : private Alloc {
+protected:
+    allocator_holder() = default;
+
+    explicit allocator_holder(const Alloc &allocator) noexcept
+        : Alloc(allocator) {
+    }
+
+    Alloc &allocator() noexcept {
+        return *this;
+    }
+
+    const Alloc &allocator() const noexcept {
+        return *this;
+    }
+};
+
+template <typename Alloc>
+class allocator_holder<Alloc, false> {
+    Alloc allocator_;
+
+protected:
+    allocator_holder() = default;
+
+    explicit allocator_holder(const Alloc &allocator) noexcept
+        : allocator_(allocator) {
+    }
+
+    Alloc &allocator() noexcept {
+        return allocator_;
+    }
+
+    const Alloc &allocator() const noexcept {
+        return allocator_;
+    }
+};
+}  // namespace detail
+
+// Deleter freeing `size` elements in storage for `capacity` elements obtained
+// from `allocator`.
+template <typename T, typename Alloc = std::allocator<T>>
+struct buffer_deleter {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::size_t size = 0;
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::size_t capacity = 0;
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    Alloc allocator;
+
+    void operator()(T *data) noexcept {
+        std::destroy_n(data, size);
+        std::allocator_traits<Alloc>::deallocate(allocator, data, capacity);
+    }
+};
+
+// Owning handle to the buffer of a vector: `size()` constructed elements in
+// storage for `capacity()` elements obtained from the allocator. Moves
+// between vectors, std::unique_ptr and C APIs without copying elements.
 template <typename T, typename Alloc = std::allocator<T>>
-class vector {
+class vector_buffer : private detail::allocator_holder<Alloc> {
+    using detail::allocator_holder<Alloc>::allocator;
+    T *data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+
+public:
+    vector_buffer() noexcept(std::is_nothrow_default_constructible_v<Alloc>) =
+        default;
+
+    vector_buffer(T *data,
+                  std::size_t size,
+                  std::size_t capacity,
+                  const Alloc &allocator = Alloc()) noexcept
+        : detail::allocator_holder<Alloc>(allocator),
+          data_(data),
+          size_(size),
+          capacity_(capacity) {
+        assert(size_ <= capacity_);
+        assert((data_ == nullptr) == (capacity_ == 0));
+    }
+
+    explicit vector_buffer(
+        std::unique_ptr<T[], buffer_deleter<T, Alloc>> &&pointer) noexcept
+        : vector_buffer(pointer.get(),
+                        pointer.get_deleter().size,
+                        pointer.get_deleter().capacity,
+                        pointer.get_deleter().allocator) {
+        pointer.release();
+    }
+
+    vector_buffer(const vector_buffer &) = delete;
+    vector_buffer &operator=(const vector_buffer &) = delete;
+
+    vector_buffer(vector_buffer &&other) noexcept
+        : detail::allocator_holder<Alloc>(other.allocator()),
+          data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          capacity_(std::exchange(other.capacity_, 0)) {
+    }
+
+    // Unless the allocator propagates on move assignment, `other` must use
+    // an equal allocator, since this buffer frees the storage through its
+    // own.
+    vector_buffer &operator=(vector_buffer &&other) noexcept {
+        if (this != &other) {
+            reset();
+            if constexpr (std::allocator_traits<Alloc>::
+                              propagate_on_container_move_assignment::value) {
+                using std::swap;
+                swap(allocator(), other.allocator());
+            } else {
+                assert(allocator() == other.allocator());
+            }
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+            std::swap(capacity_, other.capacity_);
+        }
+        return *this;
+    }
+
+    ~vector_buffer() noexcept {
+        reset();
+    }
+
+    [[nodiscard]] T *data() const noexcept {
+        return data_;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return size_;
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept {
+        return capacity_;
+    }
+
+    [[nodiscard]] Alloc get_allocator() const noexcept {
+        return allocator();
+    }
+
+    // Gives up ownership. The caller becomes responsible for destroying the
+    // elements and freeing the storage through the allocator.
+    [[nodiscard]] T *release() noexcept {
+        size_ = 0;
+        capacity_ = 0;
+        return std::exchange(data_, nullptr);
+    }
+
+    [[nodiscard]] std::unique_ptr<T[], buffer_deleter<T, Alloc>>
+    to_unique_ptr() && noexcept {
+        buffer_deleter<T, Alloc> deleter{size_, capacity_, allocator()};
+        return {release(), std::move(deleter)};
+    }
+
+    void reset() noexcept {
+        if (data_ != nullptr) {
+            buffer_deleter<T, Alloc>{size_, capacity_, allocator()}(data_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        capacity_ = 0;
+    }
+};
+
+// Result of the try_* members of vector, which report running out of memory
+// instead of throwing std::bad_alloc. Exceptions thrown by element
+// constructors still propagate.
+enum class vector_status { ok, out_of_memory };
+
+// What a vector guarantees when constructing an element throws.
+namespace exception_policy {
+// The vector is left as it was.
+struct strong {};
+
+// The elements are left as they were, but growing may already have moved
+// them to a larger buffer: new elements are constructed in place after
+// reallocating instead of in a staging buffer next to the old one.
+struct basic {};
+
+// Constructing an element must not throw, which is checked at compile time,
+// and no rollback code is generated. Growing constructs in place like basic.
+struct nothrow {};
+}  // namespace exception_policy
+
+template <typename T,
+          typename Alloc = std::allocator<T>,
+          typename ExceptionPolicy = exception_policy::strong,
+          typename StatsPolicy = stats_policy::none>
+class vector : private detail::allocator_holder<Alloc>,
+               private detail::slack_tracking<T, StatsPolicy> {
     static_assert(std::is_nothrow_move_constructible_v<T>);
     static_assert(std::is_nothrow_move_assignable_v<T>);
     static_assert(std::is_nothrow_destructible_v<T>);
+    static_assert(
+        std::is_same_v<ExceptionPolicy, exception_policy::strong> ||
+            std::is_same_v<ExceptionPolicy, exception_policy::basic> ||
+            std::is_same_v<ExceptionPolicy, exception_policy::nothrow>,
+        "unknown exception policy");
+    using alloc_traits = std::allocator_traits<Alloc>;
+    using detail::allocator_holder<Alloc>::allocator;
+    static constexpr bool nothrow_policy =
+        std::is_same_v<ExceptionPolicy, exception_policy::nothrow>;
+    static constexpr bool records_stats =
+        !std::is_same_v<StatsPolicy, stats_policy::none>;
     T *data_ = nullptr;
     std::size_t capacity_ = 0;
     std::size_t size_ = 0;
 
-    void destruct(T *data, std::size_t begin, std::size_t end) {
-        for (std::size_t delete_index = begin; delete_index < end;
-             delete_index++) {
-            (data + delete_index)->~T();
+    void record_allocation(std::size_t capacity) noexcept {
+        if constexpr (records_stats) {
+            StatsPolicy::template counters<T>().allocated(capacity * sizeof(T));
+        }
+    }
+
+    // Called before the elements are relocated, while size_ counts them.
+    void record_reallocation(std::size_t new_capacity) noexcept {
+        if constexpr (records_stats) {
+            if (data_ != nullptr) {
+                StatsPolicy::template counters<T>().reallocated(
+                    size_, new_capacity * sizeof(T));
+            }
+        }
+    }
+
+    void record_copies(std::size_t count) noexcept {
+        if constexpr (records_stats) {
+            StatsPolicy::template counters<T>().copied(count * sizeof(T));
+        }
+    }
+
+    void record_rollback() noexcept {
+        if constexpr (records_stats) {
+            StatsPolicy::template counters<T>().rolled_back();
+        }
+    }
+
+    // Called after every change of the size or capacity.
+    void record_slack() noexcept {
+        if constexpr (detail::tracks_slack<StatsPolicy>::value) {
+            this->slack_changed(size_, capacity_);
         }
     }
 
+    // Whether `element` is one of the elements, which growing in place moves
+    // or frees before the new elements are copied from it.
+    [[nodiscard]] bool is_element(const T &element) const noexcept {
+        std::less<const T *> less;
+        return !less(std::addressof(element), data_) &&
+               less(std::addressof(element), data_ + size_);
+    }
+
+    void destruct(T *data, std::size_t begin, std::size_t end) {
+        std::destroy(data + begin, data + end);
+    }
+
     T *alloc(std::size_t capacity) {
         if (capacity == 0) {
             return nullptr;
         }
-        return Alloc().allocate(capacity);
+        T *result = alloc_traits::allocate(allocator(), capacity);
+        record_allocation(capacity);
+        return result;
+    }
+
+    // Like alloc(), but returns nullptr when the allocator is out of memory.
+    // Allocators may provide `T *try_allocate(std::size_t)` that does so
+    // without throwing; std::allocator uses the nothrow operator new.
+    T *try_alloc(std::size_t capacity) noexcept {
+        if constexpr (detail::has_try_allocate<Alloc>::value ||
+                      (std::is_same_v<Alloc, std::allocator<T>> &&
+                       alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)) {
+            T *result = nullptr;
+            if constexpr (detail::has_try_allocate<Alloc>::value) {
+                result = allocator().try_allocate(capacity);
+            } else if (capacity <= alloc_traits::max_size(allocator())) {
+                result = static_cast<T *>(
+                    ::operator new(capacity * sizeof(T), std::nothrow));
+            }
+            if (result != nullptr) {
+                record_allocation(capacity);
+            }
+            return result;
+        } else {
+            T *result = nullptr;
+            LAB_07_TRY {
+                result = alloc(capacity);
+            }
+            LAB_07_CATCH(const std::bad_alloc &) {
+            }
+            return result;
+        }
     }
 
     void dealloc(T *data, std::size_t capacity) {
         if (data == nullptr || capacity == 0) {
             return;
         }
-        Alloc().deallocate(data, capacity);
+        alloc_traits::deallocate(allocator(), data, capacity);
+    }
+
+    // Allocators may provide `T *reallocate(T *, old_capacity, new_capacity)`
+    // which preserves the bytes of the buffer (e.g. via mremap). It is only
+    // used when elements can be relocated bytewise and nothing else can throw.
+    static constexpr bool can_reallocate =
+        is_trivially_relocatable_v<T> && detail::has_reallocate<Alloc>::value;
+
+    // Whether growing may move the elements to the new buffer before the new
+    // elements are constructed, instead of constructing those in a staging
+    // buffer first.
+    static constexpr bool grows_in_place =
+        !std::is_same_v<ExceptionPolicy, exception_policy::strong> ||
+        (can_reallocate && std::is_nothrow_default_constructible_v<T> &&
+         std::is_nothrow_copy_constructible_v<T>);
+
+    // Runs `body`, timing it as `phase` of a growth to `new_capacity` if the
+    // stats policy times growth.
+    template <typename Body>
+    void time_growth(growth_phase phase,
+                     std::size_t new_capacity,
+                     const Body &body) {
+        if constexpr (detail::times_growth<StatsPolicy>::value) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            StatsPolicy::template growth_timed<T>(
+                phase, new_capacity * sizeof(T),
+                static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        elapsed)
+                        .count()));
+        } else {
+            body();
+        }
+    }
+
+    // Moves the elements to `extradata`, which holds `new_capacity`
+    // elements, and frees the old buffer. Leaves capacity_ to the caller.
+    void relocate_to(T *extradata, std::size_t new_capacity) {
+        if (data_ != nullptr) {
+            record_reallocation(new_capacity);
+            time_growth(growth_phase::relocate, new_capacity, [&] {
+                construct_section_move(extradata, 0, size_);
+                destruct(data_, 0, size_);
+            });
+            time_growth(growth_phase::deallocate, new_capacity,
+                        [&] { dealloc(data_, capacity_); });
+        }
+        data_ = extradata;
     }
 
     void increase_capacity(std::size_t new_capacity) {
-        T *extradata = alloc(new_capacity);
-        construct_section_move(extradata, 0, size_);
-        destruct(data_, 0, size_);
-        dealloc(data_, capacity_);
-        std::swap(data_, extradata);
+        LAB_07_PROBE(grow, this, capacity_, new_capacity, sizeof(T));
+        if constexpr (can_reallocate) {
+            if (data_ != nullptr) {
+                time_growth(growth_phase::relocate, new_capacity, [&] {
+                    data_ =
+                        allocator().reallocate(data_, capacity_, new_capacity);
+                });
+                record_reallocation(new_capacity);
+                return;
+            }
+        }
+        T *extradata = nullptr;
+        time_growth(growth_phase::allocate, new_capacity,
+                    [&] { extradata = alloc(new_capacity); });
+        relocate_to(extradata, new_capacity);
+    }
+
+    // Constructs elements [begin, end), destroying the constructed ones if
+    // one of them throws.
+    template <typename InitFunc>
+    void construct_range(T *data,
+                         std::size_t begin,
+                         std::size_t end,
+                         const InitFunc &init_func) {
+        if constexpr (nothrow_policy) {
+            static_assert(std::is_nothrow_invocable_v<const InitFunc &, T *>,
+                          "exception_policy::nothrow requires element "
+                          "construction that does not throw");
+            for (std::size_t index = begin; index < end; index++) {
+                init_func(data + index);
+            }
+        } else {
+            std::size_t delete_index = begin;
+            LAB_07_TRY {
+                for (std::size_t index = begin; index < end; index++) {
+                    delete_index = index;
+                    init_func(data + index);
+                }
+            }
+            LAB_07_CATCH(...) {
+                destruct(data, begin, delete_index);
+                LAB_07_RETHROW;
+            }
+        }
+    }
+
+    // Like increase_capacity(), but returns false instead of throwing when
+    // the allocator is out of memory.
+    [[nodiscard]] bool try_increase_capacity(std::size_t new_capacity) {
+        LAB_07_PROBE(grow, this, capacity_, new_capacity, sizeof(T));
+        if constexpr (can_reallocate) {
+            if (data_ != nullptr) {
+                LAB_07_TRY {
+                    time_growth(growth_phase::relocate, new_capacity, [&] {
+                        data_ = allocator().reallocate(data_, capacity_,
+                                                       new_capacity);
+                    });
+                    record_reallocation(new_capacity);
+                    return true;
+                }
+                LAB_07_CATCH(const std::bad_alloc &) {
+                    return false;
+                }
+            }
+        }
+        T *extradata = nullptr;
+        time_growth(growth_phase::allocate, new_capacity,
+                    [&] { extradata = try_alloc(new_capacity); });
+        if (extradata == nullptr) {
+            return false;
+        }
+        relocate_to(extradata, new_capacity);
+        return true;
     }
 
     template <typename InitFunc>
@@ -63,18 +501,78 @@ class vector {
                            std::size_t begin,
                            std::size_t end,
                            const InitFunc &init_func) {
-        std::size_t delete_index = begin;
-        try {
-            for (std::size_t index = begin; index < end; index++) {
-                delete_index = index;
-                init_func(data + index);
+        if (std::size_t chunks = detail::parallel_chunks(end - begin,
+                                                         sizeof(T));
+            chunks > 1) {
+            construct_section_parallel(data, begin, end, chunks, init_func);
+            return;
+        }
+        if constexpr ((records_stats || LAB_07_PROBES_ENABLED) &&
+                      !nothrow_policy) {
+            LAB_07_TRY {
+                construct_range(data, begin, end, init_func);
+            }
+            LAB_07_CATCH(...) {
+                record_rollback();
+                LAB_07_PROBE(rollback, this, capacity_, end - begin,
+                             sizeof(T));
+                LAB_07_RETHROW;
             }
-        } catch (...) {
-            destruct(data, begin, delete_index);
-            throw;
+        } else {
+            construct_range(data, begin, end, init_func);
         }
     }
 
+    // Constructs every chunk on its own thread. If any chunk throws, the
+    // chunks that succeeded are destroyed and the first exception is rethrown.
+    template <typename InitFunc>
+    void construct_section_parallel(T *data,
+                                    std::size_t begin,
+                                    std::size_t end,
+                                    std::size_t chunks,
+                                    const InitFunc &init_func) {
+        if constexpr (nothrow_policy) {
+            detail::thread_pool::instance().run(
+                chunks, detail::parallel_thread_count(),
+                [&](std::size_t chunk) {
+                    auto [chunk_begin, chunk_end] =
+                        detail::chunk_bounds(begin, end, chunk, chunks);
+                    construct_range(data, chunk_begin, chunk_end, init_func);
+                });
+            return;
+        }
+        auto errors = std::make_unique<std::exception_ptr[]>(chunks);
+        detail::thread_pool::instance().run(
+            chunks, detail::parallel_thread_count(), [&](std::size_t chunk) {
+                auto [chunk_begin, chunk_end] =
+                    detail::chunk_bounds(begin, end, chunk, chunks);
+                LAB_07_TRY {
+                    construct_range(data, chunk_begin, chunk_end, init_func);
+                }
+                LAB_07_CATCH(...) {
+                    errors[chunk] = std::current_exception();
+                }
+            });
+        std::exception_ptr *error =
+            std::find_if(errors.get(), errors.get() + chunks,
+                         [](const std::exception_ptr &chunk_error) {
+                             return chunk_error != nullptr;
+                         });
+        if (error == errors.get() + chunks) {
+            return;
+        }
+        for (std::size_t chunk = 0; chunk < chunks; chunk++) {
+            if (errors[chunk] == nullptr) {
+                auto [chunk_begin, chunk_end] =
+                    detail::chunk_bounds(begin, end, chunk, chunks);
+                destruct(data, chunk_begin, chunk_end);
+            }
+        }
+        record_rollback();
+        LAB_07_PROBE(rollback, this, capacity_, end - begin, sizeof(T));
+        std::rethrow_exception(*error);
+    }
+
     void construct_section_move(T *data, std::size_t begin, std::size_t end) {
         for (std::size_t index = begin; index < end; index++) {
             new (data + index) T(std::move(*(data_ + index)));
@@ -82,58 +580,219 @@ class vector {
     }
 
     template <typename InitFunc>
-    explicit vector(std::size_t n, const InitFunc &init_func)
-        : data_(alloc(calculate_capacity(n))),
+    vector(std::size_t n, const InitFunc &init_func, const Alloc &allocator)
+        : detail::allocator_holder<Alloc>(allocator),
+          data_(alloc(calculate_capacity(n))),
           capacity_(calculate_capacity(n)),
           size_(n) {
-        try {
+        if constexpr (nothrow_policy) {
             construct_section(data_, 0, size_, init_func);
-        } catch (...) {
-            size_ = 0;
-            dealloc(data_, capacity_);
-            capacity_ = 0;
-            throw;
+        } else {
+            LAB_07_TRY {
+                construct_section(data_, 0, size_, init_func);
+            }
+            LAB_07_CATCH(...) {
+                size_ = 0;
+                dealloc(data_, capacity_);
+                capacity_ = 0;
+                LAB_07_RETHROW;
+            }
         }
+        record_slack();
     }
 
     template <typename InitFunc>
     void resize(std::size_t desired_size, const InitFunc &init_func) & {
         std::size_t desired_capacity = calculate_capacity(desired_size);
         if (desired_size <= size_) {
+            if (desired_size < size_) {
+                LAB_07_PROBE(shrink, this, size_, desired_size, sizeof(T));
+            }
             destruct(data_, desired_size, size_);
         } else if (desired_size <= capacity_) {
-            try {
-                construct_section(data_, size_, desired_size, init_func);
-            } catch (...) {
-                throw;
-            }
+            construct_section(data_, size_, desired_size, init_func);
+        } else if constexpr (grows_in_place) {
+            LAB_07_PROBE(resize_grow, this, capacity_, desired_capacity,
+                         sizeof(T));
+            increase_capacity(desired_capacity);
+            capacity_ = desired_capacity;
+            construct_section(data_, size_, desired_size, init_func);
         } else {
-            T *extradata = alloc(desired_capacity);
-            try {
-                construct_section(extradata, size_, desired_size, init_func);
-            } catch (...) {
-                dealloc(extradata, desired_capacity);
-                throw;
+            LAB_07_PROBE(resize_grow, this, capacity_, desired_capacity,
+                         sizeof(T));
+            T *extradata = nullptr;
+            time_growth(growth_phase::allocate, desired_capacity,
+                        [&] { extradata = alloc(desired_capacity); });
+            grow_into(extradata, desired_capacity, desired_size, init_func);
+        }
+        size_ = desired_size;
+        record_slack();
+    }
+
+    // Constructs the elements from the size up to `desired_size` in
+    // `extradata`, then moves the existing elements there and makes it the
+    // buffer. Frees `extradata` if construction throws.
+    template <typename InitFunc>
+    void grow_into(T *extradata,
+                   std::size_t extracapacity,
+                   std::size_t desired_size,
+                   const InitFunc &init_func) {
+        LAB_07_PROBE(grow, this, capacity_, extracapacity, sizeof(T));
+        LAB_07_TRY {
+            construct_section(extradata, size_, desired_size, init_func);
+        }
+        LAB_07_CATCH(...) {
+            dealloc(extradata, extracapacity);
+            LAB_07_RETHROW;
+        }
+        relocate_to(extradata, extracapacity);
+        capacity_ = extracapacity;
+    }
+
+    // Like resize(), but reports running out of memory instead of throwing.
+    template <typename InitFunc>
+    vector_status try_resize(std::size_t desired_size,
+                             const InitFunc &init_func) & {
+        if (desired_size > capacity_) {
+            if (desired_size > max_size()) {
+                return vector_status::out_of_memory;
+            }
+            std::size_t desired_capacity = calculate_capacity(desired_size);
+            LAB_07_PROBE(resize_grow, this, capacity_, desired_capacity,
+                         sizeof(T));
+            if constexpr (grows_in_place) {
+                if (!try_increase_capacity(desired_capacity)) {
+                    return vector_status::out_of_memory;
+                }
+                capacity_ = desired_capacity;
+            } else {
+                T *extradata = nullptr;
+                time_growth(growth_phase::allocate, desired_capacity,
+                            [&] { extradata = try_alloc(desired_capacity); });
+                if (extradata == nullptr) {
+                    return vector_status::out_of_memory;
+                }
+                grow_into(extradata, desired_capacity, desired_size,
+                          init_func);
+                size_ = desired_size;
+                record_slack();
+                return vector_status::ok;
             }
-            construct_section_move(extradata, 0, size_);
-            destruct(data_, 0, size_);
+        }
+        resize(desired_size, init_func);
+        return vector_status::ok;
+    }
+
+    // Destroys the elements and frees the buffer, then takes over the buffer
+    // of `other`, whose allocator must be able to free it.
+    void take_buffer(vector &other) noexcept {
+        destruct(data_, 0, size_);
+        dealloc(data_, capacity_);
+        data_ = std::exchange(other.data_, nullptr);
+        capacity_ = std::exchange(other.capacity_, 0);
+        size_ = std::exchange(other.size_, 0);
+        record_slack();
+        other.record_slack();
+    }
+
+    // Move assignment from a vector whose allocator cannot free our buffer.
+    void move_elements_from(vector &other) {
+        T *extradata = data_;
+        std::size_t extracapacity = capacity_;
+        if (other.size_ > capacity_) {
+            extracapacity = calculate_capacity(other.size_);
+            extradata = alloc(extracapacity);
+        }
+        clear();
+        if (extradata != data_) {
             dealloc(data_, capacity_);
-            std::swap(data_, extradata);
-            capacity_ = desired_capacity;
+            data_ = extradata;
+            capacity_ = extracapacity;
         }
-        size_ = desired_size;
+        for (std::size_t index = 0; index < other.size_; index++) {
+            new (data_ + index) T(std::move(other.data_[index]));
+        }
+        size_ = other.size_;
+        record_slack();
+        other.clear();
     }
 
 public:
-    vector() noexcept = default;
+    using value_type = T;
+    using allocator_type = Alloc;
+
+    vector() noexcept(std::is_nothrow_default_constructible_v<Alloc>) =
+        default;
+
+    explicit vector(const Alloc &allocator) noexcept
+        : detail::allocator_holder<Alloc>(allocator) {
+    }
+
+    explicit vector(std::size_t n, const Alloc &allocator = Alloc())
+        : vector(
+              n,
+              [](T *object_pointer) noexcept(
+                  std::is_nothrow_default_constructible_v<T>) {
+                  new (object_pointer) T();
+              },
+              allocator) {
+    }
+
+    vector(std::size_t n, const T &element, const Alloc &allocator = Alloc())
+        : vector(
+              n,
+              [&](T *object_pointer) noexcept(
+                  std::is_nothrow_copy_constructible_v<T>) {
+                  new (object_pointer) T(element);
+              },
+              allocator) {
+        record_copies(n);
+    }
+
+    [[nodiscard]] Alloc get_allocator() const noexcept {
+        return allocator();
+    }
+
+    explicit vector(vector_buffer<T, Alloc> &&buffer) noexcept
+        : detail::allocator_holder<Alloc>(buffer.get_allocator()),
+          capacity_(buffer.capacity()),
+          size_(buffer.size()) {
+        data_ = buffer.release();
+        record_slack();
+    }
+
+    // Hands the buffer over to the caller without copying; the vector is
+    // left empty with no capacity.
+    [[nodiscard]] vector_buffer<T, Alloc> release() &noexcept {
+        vector_buffer<T, Alloc> buffer(std::exchange(data_, nullptr),
+                                       std::exchange(size_, 0),
+                                       std::exchange(capacity_, 0),
+                                       allocator());
+        record_slack();
+        return buffer;
+    }
+
+    // Replaces the contents with the buffer. If allocators differ and do not
+    // propagate on move assignment, elements are moved into a new buffer.
+    void adopt(vector_buffer<T, Alloc> &&buffer) & {
+        *this = vector(std::move(buffer));
+    }
+
+    // Adopts `size` constructed elements in storage for `capacity` elements
+    // that the vector's allocator can free. Takes the storage directly
+    // rather than through move assignment, which may move elements.
+    void adopt(T *data, std::size_t size, std::size_t capacity) &noexcept {
+        vector adopted(
+            vector_buffer<T, Alloc>(data, size, capacity, allocator()));
+        take_buffer(adopted);
+    }
 
-    explicit vector(std::size_t n)
-        : vector(n, [](T *object_pointer) { new (object_pointer) T(); }) {
+    [[nodiscard]] T *data() noexcept {
+        return data_;
     }
 
-    vector(std::size_t n, const T &element)
-        : vector(n,
-                 [&](T *object_pointer) { new (object_pointer) T(element); }) {
+    [[nodiscard]] const T *data() const noexcept {
+        return data_;
     }
 
     [[nodiscard]] T &operator[](std::size_t index) &noexcept {
@@ -160,6 +819,10 @@ public:
         return capacity_;
     }
 
+    [[nodiscard]] std::size_t max_size() const noexcept {
+        return alloc_traits::max_size(allocator());
+    }
+
     ~vector() noexcept {
         for (std::size_t index = 0; index < size_; index++) {
             (data_ + index)->~T();
@@ -182,108 +845,270 @@ public:
         new (data_ + size_) T(std::move(element));
         size_++;
         capacity_ = new_capacity;
+        record_slack();
     }
 
     void push_back(const T &element) & {
         resize(size_ + 1, element);
     }
 
+    // The try_* members report running out of memory instead of throwing
+    // std::bad_alloc and leave the vector unchanged when they do, so they
+    // work in builds without exceptions.
+    template <typename... Args>
+    [[nodiscard]] vector_status try_emplace_back(Args &&...args) & {
+        if (size_ == capacity_ ||
+            !std::is_nothrow_constructible_v<T, Args...>) {
+            // Constructed before growing, so the arguments may refer to
+            // elements and a throwing constructor leaves the capacity
+            // unchanged.
+            T element(std::forward<Args>(args)...);
+            if (size_ == capacity_ &&
+                try_reserve(size_ + 1) != vector_status::ok) {
+                return vector_status::out_of_memory;
+            }
+            new (data_ + size_) T(std::move(element));
+        } else {
+            new (data_ + size_) T(std::forward<Args>(args)...);
+        }
+        size_++;
+        record_slack();
+        return vector_status::ok;
+    }
+
+    [[nodiscard]] vector_status try_push_back(T &&element) & {
+        return try_emplace_back(std::move(element));
+    }
+
+    [[nodiscard]] vector_status try_push_back(const T &element) & {
+        vector_status status = try_emplace_back(element);
+        if (status == vector_status::ok) {
+            record_copies(1);
+        }
+        return status;
+    }
+
     void pop_back() &noexcept {
         assert(!empty());
         (data_ + size_ - 1)->~T();
         size_--;
+        record_slack();
     }
 
     vector(const vector &other)
-        : data_(alloc(calculate_capacity(other.size_))),
-          capacity_(calculate_capacity(other.size_)),
-          size_(other.size_) {
-        std::size_t delete_index = 0;
-        try {
-            for (std::size_t index = 0; index < other.size_; index++) {
-                delete_index = index;
-                new (data_ + index) T(other[index]);
-            }
-        } catch (...) {
-            destruct(data_, 0, delete_index);
-            size_ = 0;
-            dealloc(data_, capacity_);
-            capacity_ = 0;
-            throw;
-        }
+        : vector(other,
+                 alloc_traits::select_on_container_copy_construction(
+                     other.allocator())) {
+    }
+
+    vector(const vector &other, const Alloc &allocator)
+        : vector(
+              other.size_,
+              [&](T *object_pointer) noexcept(
+                  std::is_nothrow_copy_constructible_v<T>) {
+                  new (object_pointer) T(other.data_[object_pointer - data_]);
+              },
+              allocator) {
+        record_copies(size_);
     }
 
     vector &operator=(const vector &other) {
         if (this == &other) {
             return *this;
         }
-        *this = vector(other);
+        constexpr bool propagate =
+            alloc_traits::propagate_on_container_copy_assignment::value;
+        vector copy(other, propagate ? other.allocator() : allocator());
+        if constexpr (propagate) {
+            clear();
+            dealloc(data_, capacity_);
+            data_ = nullptr;
+            capacity_ = 0;
+            allocator() = other.allocator();
+        }
+        take_buffer(copy);
         return *this;
     }
 
     vector(vector &&other) noexcept
-        : data_(std::exchange(other.data_, nullptr)),
+        : detail::allocator_holder<Alloc>(other.allocator()),
+          data_(std::exchange(other.data_, nullptr)),
           capacity_(std::exchange(other.capacity_, 0)),
           size_(std::exchange(other.size_, 0)) {
+        record_slack();
+        other.record_slack();
     }
 
-    vector &operator=(vector &&other) noexcept {
+    vector &operator=(vector &&other) noexcept(
+        alloc_traits::propagate_on_container_move_assignment::value ||
+        alloc_traits::is_always_equal::value) {
+        if constexpr (!alloc_traits::propagate_on_container_move_assignment::
+                          value &&
+                      !alloc_traits::is_always_equal::value) {
+            if (this != &other && allocator() != other.allocator()) {
+                move_elements_from(other);
+                return *this;
+            }
+        }
         clear();
         if (this == &other) {
             return *this;
         }
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::
+                          value) {
+            using std::swap;
+            swap(allocator(), other.allocator());
+        }
         std::swap(capacity_, other.capacity_);
         std::swap(data_, other.data_);
         std::swap(size_, other.size_);
+        record_slack();
+        other.record_slack();
         return *this;
     }
 
     void clear() &noexcept {
         destruct(data_, 0, size_);
         size_ = 0;
+        record_slack();
     }
 
     void resize(std::size_t desired_size) & {
-        resize(desired_size,
-               [](T *object_pointer) { new (object_pointer) T(); });
+        auto init = [](T *object_pointer) noexcept(
+                        std::is_nothrow_default_constructible_v<T>) {
+            new (object_pointer) T();
+        };
+        resize(desired_size, init);
     }
 
     void resize(std::size_t desired_size, const T &element) & {
-        resize(desired_size,
-               [&](T *object_pointer) { new (object_pointer) T(element); });
+        if constexpr (grows_in_place) {
+            if (desired_size > capacity_ && is_element(element)) {
+                T copy(element);
+                record_copies(1);
+                resize(desired_size, copy);
+                return;
+            }
+        }
+        auto init = [&](T *object_pointer) noexcept(
+                        std::is_nothrow_copy_constructible_v<T>) {
+            new (object_pointer) T(element);
+        };
+        std::size_t old_size = size_;
+        resize(desired_size, init);
+        record_copies(desired_size > old_size ? desired_size - old_size : 0);
+    }
+
+    [[nodiscard]] vector_status try_resize(std::size_t desired_size) & {
+        auto init = [](T *object_pointer) noexcept(
+                        std::is_nothrow_default_constructible_v<T>) {
+            new (object_pointer) T();
+        };
+        return try_resize(desired_size, init);
+    }
+
+    [[nodiscard]] vector_status try_resize(std::size_t desired_size,
+                                           const T &element) & {
+        if constexpr (grows_in_place) {
+            if (desired_size > capacity_ && is_element(element)) {
+                T copy(element);
+                record_copies(1);
+                return try_resize(desired_size, copy);
+            }
+        }
+        auto init = [&](T *object_pointer) noexcept(
+                        std::is_nothrow_copy_constructible_v<T>) {
+            new (object_pointer) T(element);
+        };
+        std::size_t old_size = size_;
+        vector_status status = try_resize(desired_size, init);
+        if (status == vector_status::ok && desired_size > old_size) {
+            record_copies(desired_size - old_size);
+        }
+        return status;
     }
 
     T &at(std::size_t index) & {
         if (index >= size_) {
-            throw std::out_of_range("out of range");
+            LAB_07_THROW(std::out_of_range("out of range"));
         }
         return data_[index];
     }
 
     const T &at(std::size_t index) const & {
         if (index >= size_) {
-            throw std::out_of_range("out of range");
+            LAB_07_THROW(std::out_of_range("out of range"));
         }
         return data_[index];
     }
 
     T &&at(std::size_t index) && {
         if (index >= size_) {
-            throw std::out_of_range("out of range");
+            LAB_07_THROW(std::out_of_range("out of range"));
         }
         return std::move(data_[index]);
     }
 
+    // Returns nullptr if `index` is out of range.
+    [[nodiscard]] T *try_at(std::size_t index) &noexcept {
+        return index < size_ ? data_ + index : nullptr;
+    }
+
+    [[nodiscard]] const T *try_at(std::size_t index) const &noexcept {
+        return index < size_ ? data_ + index : nullptr;
+    }
+
     void reserve(std::size_t quantity) & {
         quantity = calculate_capacity(quantity);
         if (quantity <= capacity_) {
             return;
         }
+        LAB_07_PROBE(reserve, this, capacity_, quantity, sizeof(T));
         increase_capacity(quantity);
         capacity_ = quantity;
+        record_slack();
+    }
+
+    [[nodiscard]] vector_status try_reserve(std::size_t quantity) & {
+        if (quantity > max_size()) {
+            return vector_status::out_of_memory;
+        }
+        quantity = calculate_capacity(quantity);
+        if (quantity <= capacity_) {
+            return vector_status::ok;
+        }
+        LAB_07_PROBE(reserve, this, capacity_, quantity, sizeof(T));
+        if (!try_increase_capacity(quantity)) {
+            return vector_status::out_of_memory;
+        }
+        capacity_ = quantity;
+        record_slack();
+        return vector_status::ok;
+    }
+
+    // Makes room for a total of `count` elements and calls
+    // `operation(data(), count)`, which may overwrite any of them from index
+    // 0 on; those past the current size are not initialized, unlike in
+    // resize(). The size becomes the value returned by `operation`, at most
+    // `count`. If `operation` throws, the size is unchanged.
+    template <typename Operation>
+    void resize_and_overwrite(std::size_t count, Operation operation) & {
+        static_assert(std::is_trivially_copyable_v<T> &&
+                          std::is_trivially_destructible_v<T>,
+                      "elements must be usable without construction");
+        reserve(count);
+        std::size_t new_size = std::move(operation)(data_, count);
+        assert(new_size <= count);
+        size_ = new_size;
+        record_slack();
     }
 };
 
+namespace pmr {
+template <typename T>
+using vector = lab_07::vector<T, std::pmr::polymorphic_allocator<T>>;
+}  // namespace pmr
+
 }  // namespace lab_07
 
 #endif  // VECTOR_H_
@@ -0,0 +1,298 @@
+// Times the same scenarios against lab_07::vector and std::vector and prints
+// the results as JSON:
+//
+//     vector-bench [--size N] [--repetitions R] > results.json
+//
+// Every result reports the median time per element and the heap
+// allocations made by one run, which for push_back growth are the
+// reallocations.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "vector.h"
+
+#if defined(__GNUC__) && !defined(__clang__)
+// The replacement operator new below forwards to malloc and is paired with
+// free, which GCC flags once both are inlined.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace {
+std::atomic<std::size_t> allocations{0};
+std::atomic<std::size_t> allocated_bytes{0};
+
+struct Pod64 {
+    std::uint64_t fields[8];
+};
+
+template <typename T>
+T make_value(std::size_t index);
+
+template <>
+int make_value<int>(std::size_t index) {
+    return static_cast<int>(index);
+}
+
+template <>
+Pod64 make_value<Pod64>(std::size_t index) {
+    Pod64 value{};
+    value.fields[0] = index;
+    return value;
+}
+
+template <>
+std::string make_value<std::string>(std::size_t index) {
+    // Longer than the small string buffer, so every string allocates.
+    return "benchmark string number " + std::to_string(index);
+}
+
+template <>
+std::unique_ptr<int> make_value<std::unique_ptr<int>>(std::size_t index) {
+    return std::make_unique<int>(static_cast<int>(index));
+}
+
+std::size_t observe(int value) {
+    return static_cast<std::size_t>(value);
+}
+
+std::size_t observe(const Pod64 &value) {
+    return value.fields[0];
+}
+
+std::size_t observe(const std::string &value) {
+    return value.size();
+}
+
+std::size_t observe(const std::unique_ptr<int> &value) {
+    return value ? static_cast<std::size_t>(*value) : 0;
+}
+
+volatile std::size_t sink;
+
+template <typename T>
+const char *type_name();
+
+template <>
+const char *type_name<int>() {
+    return "int";
+}
+
+template <>
+const char *type_name<Pod64>() {
+    return "pod64";
+}
+
+template <>
+const char *type_name<std::string>() {
+    return "std::string";
+}
+
+template <>
+const char *type_name<std::unique_ptr<int>>() {
+    return "std::unique_ptr<int>";
+}
+
+struct Options {
+    std::size_t size = 100'000;
+    std::size_t repetitions = 11;
+};
+
+class Reporter {
+    bool first_ = true;
+
+public:
+    Reporter() {
+        std::printf("{\n  \"benchmarks\": [");
+    }
+    Reporter(const Reporter &) = delete;
+    Reporter &operator=(const Reporter &) = delete;
+    ~Reporter() {
+        std::printf("\n  ]\n}\n");
+    }
+
+    void report(const char *container,
+                const char *type,
+                const char *scenario,
+                std::size_t size,
+                double ns_per_op,
+                std::size_t run_allocations,
+                std::size_t run_bytes) {
+        std::printf(
+            "%s\n    {\"container\": \"%s\", \"type\": \"%s\", "
+            "\"scenario\": \"%s\", \"size\": %zu, \"ns_per_op\": %.3f, "
+            "\"allocations\": %zu, \"bytes_allocated\": %zu}",
+            first_ ? "" : ",", container, type, scenario, size, ns_per_op,
+            run_allocations, run_bytes);
+        first_ = false;
+    }
+};
+
+// Runs `setup` then times `body` `repetitions` times; the allocations of
+// the last timed run are reported.
+template <typename Setup, typename Body>
+void measure(Reporter &reporter,
+             const char *container,
+             const char *type,
+             const char *scenario,
+             const Options &options,
+             Setup setup,
+             Body body) {
+    std::vector<double> timings;
+    std::size_t run_allocations = 0;
+    std::size_t run_bytes = 0;
+    for (std::size_t repetition = 0; repetition < options.repetitions;
+         repetition++) {
+        auto state = setup();
+        std::size_t allocations_before = allocations.load();
+        std::size_t bytes_before = allocated_bytes.load();
+        auto start = std::chrono::steady_clock::now();
+        body(state);
+        auto finish = std::chrono::steady_clock::now();
+        run_allocations = allocations.load() - allocations_before;
+        run_bytes = allocated_bytes.load() - bytes_before;
+        timings.push_back(
+            std::chrono::duration<double, std::nano>(finish - start).count());
+    }
+    std::nth_element(timings.begin(), timings.begin() + timings.size() / 2,
+                     timings.end());
+    reporter.report(container, type, scenario, options.size,
+                    timings[timings.size() / 2] /
+                        static_cast<double>(options.size),
+                    run_allocations, run_bytes);
+}
+
+template <template <typename...> class Vector, typename T>
+void run_scenarios(Reporter &reporter,
+                   const char *container,
+                   const Options &options) {
+    const char *type = type_name<T>();
+    std::size_t size = options.size;
+    // Values are created outside the timed section, so the scenarios time
+    // the vector rather than make_value.
+    auto values = [size] {
+        std::vector<T> result;
+        result.reserve(size);
+        for (std::size_t index = 0; index < size; index++) {
+            result.push_back(make_value<T>(index));
+        }
+        return result;
+    };
+
+    measure(reporter, container, type, "push_back", options, values,
+            [](std::vector<T> &source) {
+                Vector<T> vec;
+                for (T &value : source) {
+                    vec.push_back(std::move(value));
+                }
+                sink = observe(vec[vec.size() - 1]);
+            });
+
+    measure(reporter, container, type, "reserve_fill", options, values,
+            [](std::vector<T> &source) {
+                Vector<T> vec;
+                vec.reserve(source.size());
+                for (T &value : source) {
+                    vec.push_back(std::move(value));
+                }
+                sink = observe(vec[vec.size() - 1]);
+            });
+
+    auto filled = [&] {
+        auto source = values();
+        Vector<T> vec;
+        for (T &value : source) {
+            vec.push_back(std::move(value));
+        }
+        return vec;
+    };
+
+    if constexpr (std::is_copy_constructible_v<T>) {
+        measure(reporter, container, type, "copy", options, filled,
+                [](Vector<T> &vec) {
+                    Vector<T> copy(vec);
+                    sink = observe(copy[copy.size() - 1]);
+                });
+    }
+
+    measure(
+        reporter, container, type, "resize", options, [] { return 0; },
+        [size](int) {
+            Vector<T> vec;
+            vec.resize(size);
+            sink = vec.size();
+        });
+
+    measure(reporter, container, type, "random_access", options, filled,
+            [size](Vector<T> &vec) {
+                std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+                std::size_t total = 0;
+                for (std::size_t step = 0; step < size; step++) {
+                    state = state * 6364136223846793005ULL + 1;
+                    total += observe(vec[(state >> 33) % size]);
+                }
+                sink = total;
+            });
+}
+
+template <template <typename...> class Vector>
+void run_container(Reporter &reporter,
+                   const char *container,
+                   const Options &options) {
+    run_scenarios<Vector, int>(reporter, container, options);
+    run_scenarios<Vector, Pod64>(reporter, container, options);
+    run_scenarios<Vector, std::string>(reporter, container, options);
+    run_scenarios<Vector, std::unique_ptr<int>>(reporter, container, options);
+}
+
+Options parse_options(int argc, char **argv) {
+    Options options;
+    for (int index = 1; index + 1 < argc; index += 2) {
+        std::size_t value = std::strtoull(argv[index + 1], nullptr, 10);
+        if (std::strcmp(argv[index], "--size") == 0) {
+            options.size = std::max<std::size_t>(1, value);
+        } else if (std::strcmp(argv[index], "--repetitions") == 0) {
+            options.repetitions = std::max<std::size_t>(1, value);
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s [--size N] [--repetitions R]\n",
+                         argv[0]);
+            std::exit(2);
+        }
+    }
+    return options;
+}
+}  // namespace
+
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *result = std::malloc(size == 0 ? 1 : size)) {
+        return result;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+int main(int argc, char **argv) {
+    Options options = parse_options(argc, argv);
+    Reporter reporter;
+    run_container<lab_07::vector>(reporter, "lab_07::vector", options);
+    run_container<std::vector>(reporter, "std::vector", options);
+}
@@ -0,0 +1,50 @@
+// Compiled with -fno-exceptions, so vector.h must build without exceptions
+// and report running out of memory through the try_* members.
+#include <cstddef>
+#include <limits>
+#include "malloc_allocator.h"
+#include "vector.h"
+
+#ifndef LAB_07_NO_EXCEPTIONS
+#error "this file must be compiled without exceptions"
+#endif
+
+namespace {
+// Element type of this file only, so the vectors instantiated here do not
+// clash with the ones of translation units built with exceptions.
+struct sample {
+    int value = 0;
+};
+
+template <typename Vector>
+int check(Vector &vec) {
+    for (int value = 0; value < 100; value++) {
+        if (vec.try_push_back(sample{value}) != lab_07::vector_status::ok) {
+            return __LINE__;
+        }
+    }
+    if (vec.try_resize(150) != lab_07::vector_status::ok ||
+        vec.size() != 150 || vec.try_at(99)->value != 99 ||
+        vec.try_at(150) != nullptr) {
+        return __LINE__;
+    }
+    std::size_t capacity = vec.capacity();
+    std::size_t huge = std::numeric_limits<std::size_t>::max() / 4;
+    if (vec.try_reserve(huge) != lab_07::vector_status::out_of_memory ||
+        vec.try_resize(huge) != lab_07::vector_status::out_of_memory ||
+        vec.size() != 150 || vec.capacity() != capacity) {
+        return __LINE__;
+    }
+    return 0;
+}
+}  // namespace
+
+// Returns the line of the first failed check, or 0.
+int check_vector_without_exceptions() {
+    lab_07::vector<sample> with_new;
+    if (int line = check(with_new); line != 0) {
+        return line;
+    }
+    lab_07::vector<sample, lab_07::malloc_allocator<sample>> with_malloc;
+    return check(with_malloc);
+}
@@ -0,0 +1,64 @@
+// Compiled with LAB_07_USDT and usdt_stub/ on the include path, so the
+// probe sites of vector.h are built and their firings counted.
+#include <sys/sdt.h>
+#include "vector.h"
+
+#if !LAB_07_PROBES_ENABLED
+#error "this file must be compiled with the USDT probes enabled"
+#endif
+
+namespace {
+struct artificial_exception {};
+
+// Element type of this file only, so the vectors instantiated here do not
+// clash with the ones of translation units built without probes.
+struct probed {
+    bool can_copy = true;
+
+    probed() = default;
+
+    probed(const probed &other) : can_copy(other.can_copy) {
+        if (!can_copy) {
+            throw artificial_exception();
+        }
+    }
+
+    probed(probed &&) noexcept = default;
+    probed &operator=(const probed &) = default;
+    probed &operator=(probed &&) noexcept = default;
+    ~probed() = default;
+};
+}  // namespace
+
+int check_vector_probes() {
+    lab_07::vector<probed> v;
+    v.push_back(probed());
+    v.push_back(probed());
+    if (usdt_stub_fired.grow != 2) {
+        return __LINE__;
+    }
+    v.reserve(8);
+    v.resize(6);
+    if (usdt_stub_fired.reserve != 1 || usdt_stub_fired.resize_grow != 0) {
+        return __LINE__;
+    }
+    v.resize(6);
+    v.resize(3);
+    if (usdt_stub_fired.shrink != 1) {
+        return __LINE__;
+    }
+    v.resize(20);
+    if (usdt_stub_fired.resize_grow != 1 || usdt_stub_fired.grow != 4) {
+        return __LINE__;
+    }
+    probed broken;
+    broken.can_copy = false;
+    try {
+        v.resize(21, broken);
+    } catch (const artificial_exception &) {
+    }
+    if (usdt_stub_fired.rollback != 1 || v.size() != 20) {
+        return __LINE__;
+    }
+    return 0;
+}
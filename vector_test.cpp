@@ -1,10 +1,18 @@
 #include "vector.h"
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory_resource>
+#include <memory>
+#include <new>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 #include "doctest.h"
+#include "malloc_allocator.h"
 
 #ifdef TEST_STD_VECTOR
 using std::vector;
@@ -1043,3 +1051,320 @@ TEST_CASE(
     CHECK(res.delete_total_elems == 16);
 #endif
 }
+
+#ifndef TEST_STD_VECTOR
+TEST_CASE("release and adopt move the buffer without copying") {
+    vector<MinimalObj> v;
+    v.push_back(MinimalObj(10));
+    v.push_back(MinimalObj(11));
+    v.push_back(MinimalObj(12));
+    v.push_back(MinimalObj(13));
+    v.push_back(MinimalObj(14));
+    MinimalObj *orig_buf = v.data();
+
+    lab_07::vector_buffer<MinimalObj> buffer = v.release();
+    CHECK(v.empty());
+    CHECK(v.capacity() == 0);
+    CHECK(v.data() == nullptr);
+    CHECK(buffer.data() == orig_buf);
+    CHECK(buffer.size() == 5);
+    CHECK(buffer.capacity() == 8);
+
+    SUBCASE("into a new vector") {
+        vector<MinimalObj> w(std::move(buffer));
+        REQUIRE(w.size() == 5);
+        CHECK(w.capacity() == 8);
+        CHECK(&w[0] == orig_buf);
+        CHECK(w[4].id == 14);
+    }
+
+    SUBCASE("through std::unique_ptr") {
+        auto pointer = std::move(buffer).to_unique_ptr();
+        CHECK(buffer.data() == nullptr);
+        CHECK(pointer.get() == orig_buf);
+        CHECK(pointer[4].id == 14);
+
+        vector<MinimalObj> w;
+        w.push_back(MinimalObj(20));
+        w.adopt(lab_07::vector_buffer<MinimalObj>(std::move(pointer)));
+        REQUIRE(w.size() == 5);
+        CHECK(&w[0] == orig_buf);
+        CHECK(w[0].id == 10);
+    }
+}
+
+TEST_CASE("buffers are exchanged with C through malloc_allocator") {
+    vector<char, lab_07::malloc_allocator<char>> v;
+    v.push_back('a');
+    v.push_back('b');
+    v.push_back('\0');
+    lab_07::vector_buffer<char, lab_07::malloc_allocator<char>> buffer =
+        v.release();
+    std::size_t size = buffer.size();
+    char *raw = buffer.release();
+    CHECK(size == 3);
+    CHECK(std::strcmp(raw, "ab") == 0);
+    std::free(raw);
+
+    auto *c_buffer = static_cast<char *>(std::malloc(16));
+    REQUIRE(c_buffer != nullptr);
+    std::memcpy(c_buffer, "xyz", 3);
+    v.adopt(c_buffer, 3, 16);
+    REQUIRE(v.size() == 3);
+    CHECK(v.capacity() == 16);
+    CHECK(v[2] == 'z');
+    v.push_back('w');
+    CHECK(v.data() == c_buffer);
+}
+
+TEST_CASE("released buffer frees through the allocator") {
+    Counters res = with_counters([]() {
+        vector<std::string, CounterAllocator<std::string>> vec(
+            10, std::string(500U, 'x'));
+        lab_07::vector_buffer<std::string, CounterAllocator<std::string>>
+            buffer = vec.release();
+        CHECK(buffer.size() == 10);
+    });
+    CHECK(res.new_count == 1);
+    CHECK(res.delete_count == 1);
+    CHECK(res.new_total_elems == 16);
+    CHECK(res.delete_total_elems == 16);
+}
+
+TEST_CASE("pmr buffers move-assign without propagating the resource") {
+    std::pmr::unsynchronized_pool_resource resource;
+    lab_07::pmr::vector<int> x(3, &resource);
+    lab_07::pmr::vector<int> y(5, &resource);
+    y[4] = 7;
+    auto buffer = x.release();
+    buffer = y.release();
+    REQUIRE(buffer.size() == 5);
+    CHECK(buffer.data()[4] == 7);
+    CHECK(buffer.get_allocator().resource() == &resource);
+
+    lab_07::pmr::vector<int> z(1, &resource);
+    int *raw = z.get_allocator().allocate(4);
+    raw[0] = 9;
+    z.adopt(raw, 1, 4);
+    CHECK(z.data() == raw);
+    CHECK(z.capacity() == 4);
+    CHECK(z[0] == 9);
+}
+
+TEST_CASE("resize_and_overwrite writes past the size without initializing") {
+    vector<char> v;
+    v.push_back('a');
+    v.resize_and_overwrite(100, [](char *data, std::size_t count) {
+        CHECK(count == 100);
+        CHECK(data[0] == 'a');
+        std::memset(data + 1, 'b', 9);
+        return std::size_t{10};
+    });
+    REQUIRE(v.size() == 10);
+    CHECK(v.capacity() >= 100);
+    CHECK(v[9] == 'b');
+
+    const char *buffer = v.data();
+    CHECK_THROWS_AS(v.resize_and_overwrite(
+                        50,
+                        [](char *, std::size_t) -> std::size_t {
+                            throw std::runtime_error("failed");
+                        }),
+                    std::runtime_error);
+    CHECK(v.size() == 10);
+    CHECK(v.data() == buffer);
+
+    v.resize_and_overwrite(4, [](char *, std::size_t count) { return count; });
+    CHECK(v.size() == 4);
+}
+
+TEST_CASE("basic exception policy keeps elements but may reallocate") {
+    struct artificial_exception {};
+    struct S {
+        // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+        std::string data = std::string(500U, 'x');
+
+        S() {
+            throw artificial_exception();
+        }
+
+        explicit S(int) {
+        }
+    };
+
+    lab_07::vector<S, std::allocator<S>, lab_07::exception_policy::basic> v;
+    v.push_back(S(10));
+    v.push_back(S(10));
+    REQUIRE(v.capacity() == 2);
+
+    CHECK_THROWS_AS(v.resize(10), artificial_exception);
+
+    REQUIRE(v.size() == 2);
+    CHECK(v.capacity() == 16);
+    CHECK(v[0].data == std::string(500U, 'x'));
+    CHECK(v[1].data == std::string(500U, 'x'));
+}
+
+TEST_CASE("nothrow exception policy constructs without rollback") {
+    using nothrow_vector =
+        lab_07::vector<int, std::allocator<int>,
+                       lab_07::exception_policy::nothrow>;
+    nothrow_vector v(3, 7);
+    v.push_back(8);
+    v.resize(6);
+    REQUIRE(v.size() == 6);
+    CHECK(v[2] == 7);
+    CHECK(v[3] == 8);
+    CHECK(v[5] == 0);
+
+    nothrow_vector copy(v);
+    REQUIRE(copy.size() == 6);
+    CHECK(copy[3] == 8);
+}
+
+namespace {
+template <typename Policy, typename T>
+void check_push_back_of_own_element(const T &value) {
+    lab_07::vector<T, std::allocator<T>, Policy> v;
+    v.push_back(value);
+    // Grows at sizes 1, 2, 4 and 8, the last time in resize().
+    while (v.size() < 8) {
+        v.push_back(v[0]);
+    }
+    REQUIRE(v.capacity() == 8);
+    v.resize(20, v[v.size() - 1]);
+    REQUIRE(v.size() == 20);
+    for (std::size_t index = 0; index < v.size(); index++) {
+        CHECK(v[index] == value);
+    }
+}
+}  // namespace
+
+TEST_CASE("push_back of an own element survives growth") {
+    std::string long_string(100U, 'x');
+    check_push_back_of_own_element<lab_07::exception_policy::strong>(
+        long_string);
+    check_push_back_of_own_element<lab_07::exception_policy::basic>(
+        long_string);
+    check_push_back_of_own_element<lab_07::exception_policy::basic>(42L);
+    check_push_back_of_own_element<lab_07::exception_policy::nothrow>(42L);
+}
+
+namespace {
+// Refuses to allocate more than `limit` elements at once.
+template <typename T>
+struct limited_allocator {
+    using value_type = T;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::size_t limit = 16;
+
+    limited_allocator() noexcept = default;
+
+    template <typename U>
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    limited_allocator(const limited_allocator<U> &other) noexcept
+        : limit(other.limit) {
+    }
+
+    T *allocate(std::size_t count) {
+        if (count > limit) {
+            throw std::bad_alloc();
+        }
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T *pointer, std::size_t count) noexcept {
+        std::allocator<T>().deallocate(pointer, count);
+    }
+
+    friend bool operator==(const limited_allocator &,
+                           const limited_allocator &) noexcept {
+        return true;
+    }
+
+    friend bool operator!=(const limited_allocator &,
+                           const limited_allocator &) noexcept {
+        return false;
+    }
+};
+}  // namespace
+
+TEST_CASE("try_* members report running out of memory") {
+    vector<std::string, limited_allocator<std::string>> v;
+    for (int index = 0; index < 16; index++) {
+        REQUIRE(v.try_push_back(std::string(100U, 'x')) ==
+                lab_07::vector_status::ok);
+    }
+    CHECK(v.try_emplace_back(3U, 'y') == lab_07::vector_status::out_of_memory);
+    CHECK(v.try_push_back(std::string("z")) ==
+          lab_07::vector_status::out_of_memory);
+    CHECK(v.try_reserve(17) == lab_07::vector_status::out_of_memory);
+    CHECK(v.try_resize(20) == lab_07::vector_status::out_of_memory);
+    REQUIRE(v.size() == 16);
+    CHECK(v.capacity() == 16);
+    CHECK(v[15] == std::string(100U, 'x'));
+
+    CHECK(v.try_resize(10, std::string("w")) == lab_07::vector_status::ok);
+    CHECK(v.size() == 10);
+    REQUIRE(v.try_at(9) != nullptr);
+    CHECK(v.try_at(10) == nullptr);
+    CHECK(*std::as_const(v).try_at(0) == std::string(100U, 'x'));
+}
+
+TEST_CASE("try_* members accept an own element") {
+    vector<long> numbers;
+    numbers.push_back(42L);
+    for (int index = 0; index < 8; index++) {
+        REQUIRE(numbers.try_push_back(numbers[0]) == lab_07::vector_status::ok);
+    }
+    REQUIRE(numbers.try_emplace_back(numbers[8]) == lab_07::vector_status::ok);
+    REQUIRE(numbers.size() == 10);
+    CHECK(numbers[9] == 42L);
+
+    vector<std::string, std::allocator<std::string>,
+           lab_07::exception_policy::basic>
+        strings;
+    strings.push_back(std::string(100U, 'x'));
+    REQUIRE(strings.try_push_back(strings[0]) == lab_07::vector_status::ok);
+    REQUIRE(strings.try_resize(10, strings[1]) == lab_07::vector_status::ok);
+    for (std::size_t index = 0; index < strings.size(); index++) {
+        CHECK(strings[index] == std::string(100U, 'x'));
+    }
+}
+
+TEST_CASE("try_reserve uses the nothrow allocation of the allocator") {
+    std::size_t huge = std::numeric_limits<std::size_t>::max() / 4;
+    vector<int, lab_07::malloc_allocator<int>> with_malloc(3);
+    CHECK(with_malloc.try_reserve(huge) ==
+          lab_07::vector_status::out_of_memory);
+    CHECK(with_malloc.capacity() == 4);
+    vector<int> with_new(3);
+    CHECK(with_new.try_reserve(huge) == lab_07::vector_status::out_of_memory);
+    CHECK(with_new.try_reserve(100) == lab_07::vector_status::ok);
+    CHECK(with_new.capacity() == 128);
+
+    // No power of two holds these, so they fail before rounding up.
+    std::size_t beyond = std::numeric_limits<std::size_t>::max() / 2 + 2;
+    CHECK(with_new.try_reserve(beyond) ==
+          lab_07::vector_status::out_of_memory);
+    CHECK(with_new.try_resize(beyond) == lab_07::vector_status::out_of_memory);
+    CHECK(with_new.try_reserve(std::numeric_limits<std::size_t>::max()) ==
+          lab_07::vector_status::out_of_memory);
+    CHECK(with_new.capacity() == 128);
+    CHECK(with_new.size() == 3);
+    CHECK(lab_07::calculate_capacity(beyond) == beyond);
+}
+
+int check_vector_without_exceptions();
+
+TEST_CASE("vector builds without exceptions") {
+    CHECK(check_vector_without_exceptions() == 0);
+}
+
+int check_vector_probes();
+
+TEST_CASE("vector fires USDT probes when they are enabled") {
+    CHECK(check_vector_probes() == 0);
+}
+#endif
@@ -0,0 +1,287 @@
+#ifndef VM_VECTOR_H_
+#define VM_VECTOR_H_
+
+#include <sys/mman.h>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "pages.h"
+#include "vector.h"
+
+namespace lab_07 {
+// Vector that reserves `ReservedBytes` of address space once (PROT_NONE) and
+// commits pages with mprotect as it grows. Elements never move, so their
+// addresses stay valid until they are destroyed, and growth has no transient
+// 2x memory peak. Capacity is always a whole number of committed pages.
+template <typename T, std::size_t ReservedBytes = (std::size_t{64} << 30)>
+class vm_vector {
+    static_assert(std::is_nothrow_move_constructible_v<T>);
+    static_assert(std::is_nothrow_move_assignable_v<T>);
+    static_assert(std::is_nothrow_destructible_v<T>);
+    T *data_ = nullptr;
+    std::size_t committed_bytes_ = 0;
+    std::size_t capacity_ = 0;
+    std::size_t size_ = 0;
+
+    void destruct(std::size_t begin, std::size_t end) {
+        std::destroy(data_ + begin, data_ + end);
+    }
+
+    void reserve_address_space() {
+        if (data_ != nullptr) {
+            return;
+        }
+        void *result = mmap(nullptr, ReservedBytes, PROT_NONE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (result == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        data_ = static_cast<T *>(result);
+    }
+
+    // Commits enough pages for at least `quantity` elements, rounding the
+    // capacity up to a power of two while the reservation allows it.
+    void commit(std::size_t quantity) {
+        if (quantity <= capacity_) {
+            return;
+        }
+        if (quantity > max_size()) {
+            throw std::length_error("vm_vector reservation exhausted");
+        }
+        reserve_address_space();
+        std::size_t new_committed_bytes = std::min(
+            detail::round_up_to_pages(calculate_capacity(quantity) * sizeof(T)),
+            ReservedBytes);
+        char *bytes = reinterpret_cast<char *>(data_);
+        if (mprotect(bytes + committed_bytes_,
+                     new_committed_bytes - committed_bytes_,
+                     PROT_READ | PROT_WRITE) != 0) {
+            throw std::bad_alloc();
+        }
+        committed_bytes_ = new_committed_bytes;
+        capacity_ = committed_bytes_ / sizeof(T);
+    }
+
+    void decommit(std::size_t new_capacity) noexcept {
+        std::size_t new_committed_bytes =
+            detail::round_up_to_pages(new_capacity * sizeof(T));
+        if (new_committed_bytes >= committed_bytes_) {
+            return;
+        }
+        char *bytes = reinterpret_cast<char *>(data_);
+        madvise(bytes + new_committed_bytes,
+                committed_bytes_ - new_committed_bytes, MADV_DONTNEED);
+        mprotect(bytes + new_committed_bytes,
+                 committed_bytes_ - new_committed_bytes, PROT_NONE);
+        committed_bytes_ = new_committed_bytes;
+        capacity_ = committed_bytes_ / sizeof(T);
+    }
+
+    template <typename InitFunc>
+    void construct_section(std::size_t begin,
+                           std::size_t end,
+                           const InitFunc &init_func) {
+        std::size_t delete_index = begin;
+        try {
+            for (std::size_t index = begin; index < end; index++) {
+                delete_index = index;
+                init_func(data_ + index);
+            }
+        } catch (...) {
+            destruct(begin, delete_index);
+            throw;
+        }
+    }
+
+    template <typename InitFunc>
+    explicit vm_vector(std::size_t n, const InitFunc &init_func) {
+        try {
+            commit(n);
+            construct_section(0, n, init_func);
+        } catch (...) {
+            release();
+            throw;
+        }
+        size_ = n;
+    }
+
+    template <typename InitFunc>
+    void resize(std::size_t desired_size, const InitFunc &init_func) & {
+        if (desired_size <= size_) {
+            destruct(desired_size, size_);
+        } else {
+            std::size_t old_capacity = capacity_;
+            try {
+                commit(desired_size);
+                construct_section(size_, desired_size, init_func);
+            } catch (...) {
+                decommit(old_capacity);
+                throw;
+            }
+        }
+        size_ = desired_size;
+    }
+
+    void release() noexcept {
+        if (data_ != nullptr) {
+            munmap(data_, ReservedBytes);
+        }
+        data_ = nullptr;
+        committed_bytes_ = 0;
+        capacity_ = 0;
+        size_ = 0;
+    }
+
+public:
+    vm_vector() noexcept = default;
+
+    explicit vm_vector(std::size_t n)
+        : vm_vector(n, [](T *object_pointer) { new (object_pointer) T(); }) {
+    }
+
+    vm_vector(std::size_t n, const T &element)
+        : vm_vector(n, [&](T *object_pointer) {
+              new (object_pointer) T(element);
+          }) {
+    }
+
+    [[nodiscard]] T &operator[](std::size_t index) &noexcept {
+        return data_[index];
+    }
+
+    [[nodiscard]] const T &operator[](std::size_t index) const &noexcept {
+        return data_[index];
+    }
+
+    [[nodiscard]] T &&operator[](std::size_t index) &&noexcept {
+        return std::move(data_[index]);
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return size_;
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept {
+        return capacity_;
+    }
+
+    [[nodiscard]] static constexpr std::size_t max_size() noexcept {
+        return ReservedBytes / sizeof(T);
+    }
+
+    ~vm_vector() noexcept {
+        destruct(0, size_);
+        release();
+    }
+
+    void push_back(T &&element) & {
+        if (size_ == capacity_) {
+            commit(size_ + 1);
+        }
+        new (data_ + size_) T(std::move(element));
+        size_++;
+    }
+
+    void push_back(const T &element) & {
+        resize(size_ + 1,
+               [&](T *object_pointer) { new (object_pointer) T(element); });
+    }
+
+    void pop_back() &noexcept {
+        assert(!empty());
+        (data_ + size_ - 1)->~T();
+        size_--;
+    }
+
+    vm_vector(const vm_vector &other)
+        : vm_vector(other.size_, [&](T *object_pointer) {
+              new (object_pointer) T(other.data_[object_pointer - data_]);
+          }) {
+    }
+
+    vm_vector &operator=(const vm_vector &other) {
+        if (this == &other) {
+            return *this;
+        }
+        *this = vm_vector(other);
+        return *this;
+    }
+
+    vm_vector(vm_vector &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          committed_bytes_(std::exchange(other.committed_bytes_, 0)),
+          capacity_(std::exchange(other.capacity_, 0)),
+          size_(std::exchange(other.size_, 0)) {
+    }
+
+    vm_vector &operator=(vm_vector &&other) noexcept {
+        clear();
+        if (this == &other) {
+            return *this;
+        }
+        std::swap(data_, other.data_);
+        std::swap(committed_bytes_, other.committed_bytes_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+
+    void clear() &noexcept {
+        destruct(0, size_);
+        size_ = 0;
+    }
+
+    void resize(std::size_t desired_size) & {
+        resize(desired_size,
+               [](T *object_pointer) { new (object_pointer) T(); });
+    }
+
+    void resize(std::size_t desired_size, const T &element) & {
+        resize(desired_size,
+               [&](T *object_pointer) { new (object_pointer) T(element); });
+    }
+
+    T &at(std::size_t index) & {
+        if (index >= size_) {
+            throw std::out_of_range("out of range");
+        }
+        return data_[index];
+    }
+
+    const T &at(std::size_t index) const & {
+        if (index >= size_) {
+            throw std::out_of_range("out of range");
+        }
+        return data_[index];
+    }
+
+    T &&at(std::size_t index) && {
+        if (index >= size_) {
+            throw std::out_of_range("out of range");
+        }
+        return std::move(data_[index]);
+    }
+
+    void reserve(std::size_t quantity) & {
+        commit(quantity);
+    }
+
+    // Returns pages past the last element to the kernel. The address range
+    // stays reserved, so elements keep their addresses.
+    void shrink_to_fit() &noexcept {
+        decommit(size_);
+    }
+};
+
+}  // namespace lab_07
+
+#endif  // VM_VECTOR_H_
@@ -0,0 +1,83 @@
+#include "vm_vector.h"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include "doctest.h"
+
+TEST_CASE("vm_vector keeps element addresses while growing") {
+    lab_07::vm_vector<std::string> v;
+    CHECK(v.capacity() == 0);
+    v.push_back(std::string(500U, 'a'));
+    const std::string *first = &v[0];
+    for (int i = 0; i < 10'000; i++) {
+        v.push_back(std::string(10U, 'b'));
+    }
+    v.resize(20'000, std::string(10U, 'c'));
+    REQUIRE(v.size() == 20'000);
+    CHECK(v.capacity() >= 20'000);
+    CHECK(&v[0] == first);
+    CHECK(v[0] == std::string(500U, 'a'));
+    CHECK(v[10'000] == std::string(10U, 'b'));
+    CHECK(v[19'999] == std::string(10U, 'c'));
+}
+
+TEST_CASE("vm_vector shrink_to_fit decommits unused pages") {
+    lab_07::vm_vector<int> v(100'000);
+    std::size_t big_capacity = v.capacity();
+    CHECK(big_capacity >= 100'000);
+    v.resize(10);
+    v.shrink_to_fit();
+    CHECK(v.capacity() < big_capacity);
+    CHECK(v.capacity() >= 10);
+    v.resize(100'000, 5);
+    CHECK(v[9] == 0);
+    CHECK(v[10] == 5);
+    CHECK(v[99'999] == 5);
+}
+
+TEST_CASE("vm_vector reports exhausted reservation") {
+    lab_07::vm_vector<int, 1 << 20> v;
+    CHECK(v.max_size() == (1 << 18));
+    v.resize(v.max_size());
+    CHECK(v.capacity() == v.max_size());
+    CHECK_THROWS_AS(v.push_back(1), std::length_error);
+    CHECK(v.size() == v.max_size());
+}
+
+TEST_CASE("vm_vector push_back copy keeps strong exception safety") {
+    struct artificial_exception {};
+    struct S {
+        // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+        bool can_copy;
+        // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+        std::string data = std::string(500U, 'x');
+
+        explicit S(bool can_copy_ = true) : can_copy(can_copy_) {
+        }
+
+        S(S &&) = default;
+        S &operator=(S &&) = default;
+
+        S(const S &other) : can_copy(other.can_copy) {
+            if (!other.can_copy) {
+                throw artificial_exception();
+            }
+        }
+
+        S &operator=(const S &other) = delete;
+
+        ~S() = default;
+    };
+
+    lab_07::vm_vector<S> v(4);
+    v.resize(v.capacity());
+    std::size_t capacity = v.capacity();
+
+    const S obj(false);
+    CHECK_THROWS_AS(v.push_back(obj), artificial_exception);
+
+    REQUIRE(v.size() == capacity);
+    CHECK(v.capacity() == capacity);
+    CHECK(v[0].data == std::string(500U, 'x'));
+    CHECK(v[capacity - 1].data == std::string(500U, 'x'));
+}